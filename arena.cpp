@@ -0,0 +1,52 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <cassert>
+#include <algorithm>
+#include "arena.hpp"
+
+constexpr unsigned long Arena::MIN_CAPACITY;
+constexpr unsigned long Arena::MAX_CAPACITY;
+constexpr unsigned long Arena::ALIGNMENT;
+
+Arena::Arena (): _buffer(nullptr), _capacity(0), _top(0), _overflow(false), _nbBlocks(0) {
+	reset();
+}
+
+// Every block should be freed before the thread ends: the containers built
+// by a thread should not outlive it.
+Arena::~Arena () {
+	assert(_nbBlocks == 0);
+	delete[] _buffer;
+}
+
+Arena &Arena::getLocal () {
+	static thread_local Arena arena;
+	return arena;
+}
+
+void Arena::reset () {
+	if ((_buffer == nullptr) || ((_overflow) && (_capacity < MAX_CAPACITY))) {
+		delete[] _buffer;
+		_capacity = min<unsigned long>(MAX_CAPACITY, max<unsigned long>(MIN_CAPACITY, 2 * _capacity));
+		_buffer   = new char[_capacity];
+	}
+	_top      = 0;
+	_overflow = false;
+}
@@ -0,0 +1,131 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef ARENA_HPP
+#define ARENA_HPP 1
+
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <type_traits>
+using namespace std;
+
+// Monotonic buffer for the short-lived allocations of the graph phase.
+// Freeing a block does nothing (except for the last one), but the whole
+// buffer is reused as soon as every block has been freed, which happens
+// between two graphs.  The blocks which do not fit go to the heap, and the
+// buffer is then enlarged at the next reset.
+// An arena is not thread-safe: each thread uses its own one.
+class Arena {
+
+	private:
+		static constexpr unsigned long MIN_CAPACITY = 1 << 20;
+		static constexpr unsigned long MAX_CAPACITY = 1 << 26;
+		static constexpr unsigned long ALIGNMENT    = 16;
+
+		char          *_buffer;
+		unsigned long  _capacity;
+		unsigned long  _top;
+		bool           _overflow;
+		unsigned long  _nbBlocks;
+
+	public:
+		Arena ();
+		~Arena ();
+		Arena (const Arena &) = delete;
+		Arena &operator= (const Arena &) = delete;
+
+		static Arena &getLocal ();
+
+		void *allocate (unsigned long size) {
+			size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+			if (_top + size > _capacity) {
+				_overflow = true;
+				return ::operator new(size);
+			}
+			void *block = _buffer + _top;
+			_top += size;
+			_nbBlocks++;
+			return block;
+		}
+
+		void deallocate (void *block, unsigned long size) {
+			if (! owns(block)) {
+				::operator delete(block);
+				return;
+			}
+			size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+			if (static_cast<char*>(block) + size == _buffer + _top) {
+				_top -= size;
+			}
+			if (--_nbBlocks == 0) {
+				reset();
+			}
+		}
+
+		bool owns (const void *block) const {
+			uintptr_t address = reinterpret_cast<uintptr_t>(block);
+			uintptr_t start   = reinterpret_cast<uintptr_t>(_buffer);
+			return ((address >= start) && (address < start + _capacity));
+		}
+
+	private:
+		void reset ();
+};
+
+// Allocator for the standard containers, which uses the arena of the thread
+// where the container is built.  A copy of a container is a new container,
+// so it uses the arena of the thread which copies it, and a copy-assigned
+// container keeps its arena.
+template <class T>
+class ArenaAllocator {
+
+	template <class U> friend class ArenaAllocator;
+
+	private:
+		Arena *_arena;
+
+	public:
+		typedef T         value_type;
+		typedef false_type propagate_on_container_copy_assignment;
+		typedef true_type propagate_on_container_move_assignment;
+		typedef true_type propagate_on_container_swap;
+
+		ArenaAllocator (): _arena(&Arena::getLocal()) { }
+		template <class U> ArenaAllocator (const ArenaAllocator<U> &allocator): _arena(allocator._arena) { }
+
+		ArenaAllocator select_on_container_copy_construction () const {
+			return ArenaAllocator<T>();
+		}
+
+		T *allocate (size_t n) {
+			return static_cast<T*>(_arena->allocate(n * sizeof(T)));
+		}
+		void deallocate (T *block, size_t n) {
+			_arena->deallocate(block, n * sizeof(T));
+		}
+
+		template <class U> bool operator== (const ArenaAllocator<U> &allocator) const {
+			return (_arena == allocator._arena);
+		}
+		template <class U> bool operator!= (const ArenaAllocator<U> &allocator) const {
+			return (_arena != allocator._arena);
+		}
+};
+
+template <class T>
+using ArenaVector = vector <T, ArenaAllocator<T> >;
+
+#endif
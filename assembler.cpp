@@ -27,7 +27,7 @@ along with this program.
 #include "inclusionRemover.hpp"
 #include "scaffolder.hpp"
 
-Assembler::Assembler(const char *fileName1, const char *fileName2, const char *outputFileName, int insertSize, int thresholdPc): _insertSize(insertSize), _thresholdPc(thresholdPc), _fileName1(fileName1), _fileName2(fileName2), _outputFileName(outputFileName) { }
+Assembler::Assembler(const char *fileName1, const char *fileName2, const char *outputFileName, int insertSize, int thresholdPc): _insertSize(insertSize), _thresholdPc(thresholdPc), _fileName1(fileName1), _fileName2(fileName2), _outputFileName(outputFileName), _graphKmerCount(&_kmerCount) { }
 
 void Assembler::assemble () {
 	readFiles();
@@ -125,11 +125,27 @@ void Assembler::computeDistributions () {
 }
 
 void Assembler::findRepeats () {
-	GraphRepeatFinder grf (_kmerCount, _threshold);
+	if (Globals::FROZEN_INDEX) {
+		cout << "Freezing k-mer index..." << endl;
+		_frozenKmerCount.build(_kmerCount);
+		_kmerCount.clear();
+		_graphKmerCount = &_frozenKmerCount;
+		cout << "\t" << _frozenKmerCount.getSize() << " k-mers stored, using " << (_frozenKmerCount.getMemory() * 8 / max<unsigned int>(_frozenKmerCount.getSize(), 1)) << " bits per k-mer." << endl;
+	}
+	_graphKmerCount->buildFilter();
+	_graphKmerCount->buildEdges();
+	CompactedGraph compactedGraph(_frozenKmerCount);
+	if (Globals::UNITIGS) {
+		cout << "Building unitigs..." << endl;
+		compactedGraph.build();
+		cout << "\t" << compactedGraph.getNbUnitigs() << " unitigs built." << endl;
+	}
+	GraphRepeatFinder grf (*_graphKmerCount, _threshold, (Globals::UNITIGS)? &compactedGraph: nullptr);
 	grf.findRepeats();
 	_repeats = grf.getRepeats();
 	check("Checking in the remaining hash...");
 	_kmerCount.clear();
+	_graphKmerCount = &_kmerCount;
 	_repeats.check("Checking after repeat finding...");
 }
 
@@ -144,7 +160,7 @@ void Assembler::check (const string &message) const {
 	cout << "\t\t" << message << endl;
 	for (unsigned int position = 0; position < Globals::CHECK.size() - Globals::KMER + 1; position++) {
 		string part  = Globals::CHECK.substr(position, Globals::KMER);
-		KmerNb count = _kmerCount.getCount(Kmer(part));
+		KmerNb count = _graphKmerCount->getCount(Kmer(part));
 		if (count > 0) {
 			cout << "\t\t\tGot '" << part << "' @ " << position << ", " << count << " times" << endl;
 		}
@@ -153,8 +169,10 @@ void Assembler::check (const string &message) const {
 
 void Assembler::openLoops () {
 	//cout << "Opening loops with\n" << _repeats << endl;
-	LoopOpener loopOpener (_fileName1, _repeats);
+	// The frozen index is kept until now, to give the counts of the loops.
+	LoopOpener loopOpener (_fileName1, _repeats, (Globals::FROZEN_INDEX)? &_frozenKmerCount: nullptr);
 	loopOpener.openLoops();
+	_frozenKmerCount.clear();
 	_repeats = loopOpener.getRepeats();
 	_repeats.check("Checking after loop opening...");
 }
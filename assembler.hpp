@@ -19,6 +19,8 @@ along with this program.
 #include <iostream>
 #include "fastxParser.hpp"
 #include "simpleKmerCount.hpp"
+#include "frozenKmerCount.hpp"
+#include "compactedGraph.hpp"
 #include "repeats.hpp"
 using namespace std;
 
@@ -30,6 +32,8 @@ class Assembler {
 		SimpleKmerCount   _kmerCount;
 		const char       *_fileName1, *_fileName2, *_outputFileName;
 		KmerNb            _threshold;
+		FrozenKmerCount   _frozenKmerCount;
+		KmerCount        *_graphKmerCount;
 		Repeats           _repeats;
 
     public:
@@ -0,0 +1,47 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "bloomFilter.hpp"
+
+constexpr unsigned int BloomFilter::BITS_PER_KEY;
+constexpr unsigned int BloomFilter::NB_HASHES;
+constexpr uint32_t     BloomFilter::WORD_SEED;
+constexpr uint32_t     BloomFilter::MASK_SEED;
+
+BloomFilter::BloomFilter () { }
+
+void BloomFilter::resize (const unsigned long nbKeys) {
+	_words = vector <atomic <uint64_t> > (nbKeys * BITS_PER_KEY / 64 + 1);
+	for (unsigned long i = 0; i < _words.size(); i++) {
+		_words[i] = 0;
+	}
+}
+
+void BloomFilter::clear () {
+	_words.clear();
+	_words.shrink_to_fit();
+}
+
+bool BloomFilter::empty () const {
+	return _words.empty();
+}
+
+unsigned long BloomFilter::getMemory () const {
+	return _words.size() * sizeof(uint64_t);
+}
@@ -0,0 +1,75 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef BLOOM_FILTER_HPP
+#define BLOOM_FILTER_HPP 1
+
+#include <cstdint>
+#include <atomic>
+#include <vector>
+#include "globals.hpp"
+#include "kmerCode.hpp"
+using namespace std;
+
+// Register-blocked Bloom filter: all the bits of a k-mer are in the same 64-bit word,
+// so that a query needs only one memory access.
+// An empty filter contains everything.
+class BloomFilter {
+
+	private:
+		static constexpr unsigned int BITS_PER_KEY = 12;
+		static constexpr unsigned int NB_HASHES    = 5;
+		// seeds of the hash functions, distinct from the ones of the levels of the MPHF
+		static constexpr uint32_t     WORD_SEED    = 0x9e3779b9;
+		static constexpr uint32_t     MASK_SEED    = 0x85ebca6b;
+
+		vector <atomic <uint64_t> > _words;
+
+	public:
+		BloomFilter ();
+		void resize (const unsigned long nbKeys);
+		void clear ();
+		bool empty () const;
+		unsigned long getMemory () const;
+
+		void add (const KmerCode &code) {
+			_words[getWord(code)].fetch_or(getMask(code), memory_order_relaxed);
+		}
+
+		bool contains (const KmerCode &code) const {
+			if (_words.empty()) {
+				return true;
+			}
+			uint64_t mask = getMask(code);
+			return ((_words[getWord(code)].load(memory_order_relaxed) & mask) == mask);
+		}
+
+	private:
+		unsigned long getWord (const KmerCode &code) const {
+			return (static_cast<uint64_t>(code.hash(WORD_SEED)) * _words.size()) >> 32;
+		}
+
+		static uint64_t getMask (const KmerCode &code) {
+			uint32_t hash = code.hash(MASK_SEED);
+			uint64_t mask = 0;
+			for (unsigned int i = 0; i < NB_HASHES; i++) {
+				mask  |= static_cast<uint64_t>(1) << (hash & 63);
+				hash >>= 6;
+			}
+			return mask;
+		}
+};
+
+#endif
@@ -0,0 +1,317 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thread>
+#include <algorithm>
+#include "compactedGraph.hpp"
+
+constexpr unsigned int CompactedGraph::NOT_FOUND;
+
+CompactedGraph::CompactedGraph (FrozenKmerCount &kmerCount): _kmerCount(kmerCount) { }
+
+// The unitigs are built in three steps:
+//  - the (only) possible extension of each side of each k-mer is computed,
+//  - the unitigs are spelt from the k-mers which cannot be extended on one side,
+//  - the remaining k-mers are in cycles, which are spelt sequentially.
+void CompactedGraph::build () {
+	unsigned int            size      = _kmerCount.getNbSlots();
+	unsigned int            nbThreads = max<int>(Globals::NB_THREADS, 1);
+	vector <unsigned int>   next[Globals::POSITIONS];
+	vector <unsigned char>  arrivals(size, 0);
+	vector <thread>         threads;
+	clear();
+	for (short position = 0; position < Globals::POSITIONS; position++) {
+		next[position].resize(size);
+	}
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int slot = threadId; slot < size; slot += nbThreads) {
+				for (short position = 0; position < Globals::POSITIONS; position++) {
+					short arrival = Globals::AFTER;
+					next[position][slot] = extend(slot, position, arrival);
+					if ((next[position][slot] != NOT_FOUND) && (arrival == Globals::BEFORE)) {
+						arrivals[slot] |= (1 << position);
+					}
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	threads.clear();
+
+	// Follows the extensions from a k-mer, leaving it by the given side.
+	auto walk = [&] (unsigned int slot, short position, vector <unsigned int> &slots, vector <bool> &orientations, string &word) {
+		unsigned int first = slot;
+		string       kmer  = getWord(_kmerCount.getCode(slot));
+		slots.assign(1, slot);
+		orientations.assign(1, (position == Globals::AFTER));
+		word = (position == Globals::AFTER)? kmer: Globals::getReverseComplement(kmer);
+		while ((next[position][slot] != NOT_FOUND) && (next[position][slot] != first) && (slots.size() <= size)) {
+			short    arrival = ((arrivals[slot] >> position) & 1)? Globals::BEFORE: Globals::AFTER;
+			KmerCode code;
+			slot = next[position][slot];
+			code = _kmerCount.getCode(slot);
+			if (arrival == Globals::BEFORE) {
+				word.push_back(Globals::getNucleotide(code.to_uint() & Globals::NUCLEOTIDE_MASK));
+			}
+			else {
+				word.push_back(Globals::getNucleotide(Globals::getComplementCode((code >> (Globals::NB_BITS_NUCLEOTIDES * (Globals::KMER - 1))).to_uint() & Globals::NUCLEOTIDE_MASK)));
+			}
+			slots.push_back(slot);
+			orientations.push_back(arrival == Globals::BEFORE);
+			position = 1 - arrival;
+		}
+		return slot;
+	};
+
+	vector <vector <unsigned int> >  threadStarts(nbThreads);
+	vector <vector <unsigned int> >  threadSlots(nbThreads);
+	vector <vector <string> >        threadWords(nbThreads);
+	vector <vector <KmerNb> >        threadCounts(nbThreads);
+	vector <vector <unsigned char> > threadEnds(nbThreads);
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			vector <unsigned int> slots;
+			vector <bool>         orientations;
+			string                word;
+			for (unsigned int slot = threadId; slot < size; slot += nbThreads) {
+				for (short position = 0; position < Globals::POSITIONS; position++) {
+					if (next[1 - position][slot] != NOT_FOUND) {
+						continue;
+					}
+					unsigned int last = walk(slot, position, slots, orientations, word);
+					// Each unitig is found from both ends: keep only one of them.
+					if ((slot < last) || ((slot == last) && (position == Globals::AFTER))) {
+						addUnitig(slots, orientations, word, threadStarts[threadId], threadSlots[threadId], threadWords[threadId], threadCounts[threadId], threadEnds[threadId]);
+					}
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	threads.clear();
+	_starts.push_back(0);
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		unsigned int offset = _slots.size();
+		for (unsigned int i = 1; i < threadStarts[threadId].size(); i++) {
+			_starts.push_back(offset + threadStarts[threadId][i]);
+		}
+		_slots.insert(_slots.end(), threadSlots[threadId].begin(), threadSlots[threadId].end());
+		_words.insert(_words.end(), threadWords[threadId].begin(), threadWords[threadId].end());
+		_counts.insert(_counts.end(), threadCounts[threadId].begin(), threadCounts[threadId].end());
+		_ends.insert(_ends.end(), threadEnds[threadId].begin(), threadEnds[threadId].end());
+		threadStarts[threadId].clear();
+		threadSlots[threadId].clear();
+		threadWords[threadId].clear();
+		threadCounts[threadId].clear();
+		threadEnds[threadId].clear();
+	}
+	_unitigIds.assign(size, NOT_FOUND);
+	unsigned int nbUnitigs = _words.size();
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int unitig = threadId; unitig < nbUnitigs; unitig += nbThreads) {
+				for (unsigned int i = _starts[unitig]; i < _starts[unitig+1]; i++) {
+					_unitigIds[_slots[i]] = unitig;
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+
+	vector <unsigned int> slots;
+	vector <bool>         orientations;
+	string                word;
+	vector <unsigned int> starts(1, 0);
+	for (unsigned int slot = 0; slot < size; slot++) {
+		if (_unitigIds[slot] != NOT_FOUND) {
+			continue;
+		}
+		walk(slot, Globals::AFTER, slots, orientations, word);
+		// Remove the k-mers already seen, in case the cycle goes through both strands.
+		for (unsigned int i = 0; i < slots.size(); i++) {
+			if (_unitigIds[slots[i]] != NOT_FOUND) {
+				slots.resize(i);
+				orientations.resize(i);
+				word.resize(i + Globals::KMER - 1);
+				break;
+			}
+			_unitigIds[slots[i]] = _words.size();
+		}
+		addUnitig(slots, orientations, word, starts, _slots, _words, _counts, _ends);
+		_starts.push_back(_slots.size());
+	}
+}
+
+// Returns the slot of the k-mer next to the given side, if it is the only
+// neighbor, if this side is its only neighbor, and if the counts are compatible.
+unsigned int CompactedGraph::extend (const unsigned int slot, const short position, short &arrival) const {
+	unsigned int edges = (_kmerCount.getSlotEdges(slot) >> (position * Globals::NB_NUCLEOTIDES)) & ((1 << Globals::NB_NUCLEOTIDES) - 1);
+	if (__builtin_popcount(edges) != 1) {
+		return NOT_FOUND;
+	}
+	KmerCode     code      = getNeighbor(_kmerCount.getCode(slot), __builtin_ctz(edges), position);
+	KmerCode     reverse   = getReverseComplement(code);
+	bool         direct    = ! (reverse < code);
+	unsigned int nextSlot  = _kmerCount.getSlot(direct? code: reverse);
+	if ((nextSlot == MinimalPerfectHash::NOT_FOUND) || (nextSlot == slot)) {
+		return NOT_FOUND;
+	}
+	arrival = (direct)? 1 - position: position;
+	if (__builtin_popcount((_kmerCount.getSlotEdges(nextSlot) >> (arrival * Globals::NB_NUCLEOTIDES)) & ((1 << Globals::NB_NUCLEOTIDES) - 1)) != 1) {
+		return NOT_FOUND;
+	}
+	KmerNb count     = _kmerCount.getSlotCount(slot);
+	KmerNb nextCount = _kmerCount.getSlotCount(nextSlot);
+	if ((nextCount < count / Globals::FREQUENCY_DIFFERENCE) || (nextCount > count * Globals::FREQUENCY_DIFFERENCE) || (count < nextCount / Globals::FREQUENCY_DIFFERENCE) || (count > nextCount * Globals::FREQUENCY_DIFFERENCE)) {
+		return NOT_FOUND;
+	}
+	return nextSlot;
+}
+
+// Stores the unitig in its canonical orientation.
+void CompactedGraph::addUnitig (vector <unsigned int> &slots, vector <bool> &orientations, string &word, vector <unsigned int> &starts, vector <unsigned int> &allSlots, vector <string> &words, vector <KmerNb> &counts, vector <unsigned char> &ends) const {
+	string reverse = Globals::getReverseComplement(word);
+	KmerNb count   = 0;
+	if (reverse < word) {
+		word.swap(reverse);
+		std::reverse(slots.begin(), slots.end());
+		std::reverse(orientations.begin(), orientations.end());
+		orientations.flip();
+	}
+	for (unsigned int slot: slots) {
+		count += _kmerCount.getSlotCount(slot);
+	}
+	if (starts.empty()) {
+		starts.push_back(0);
+	}
+	allSlots.insert(allSlots.end(), slots.begin(), slots.end());
+	starts.push_back(allSlots.size());
+	words.push_back(word);
+	counts.push_back(count / slots.size());
+	ends.push_back((orientations.front() << Globals::BEFORE) | (orientations.back() << Globals::AFTER));
+}
+
+unsigned int CompactedGraph::getNbUnitigs () const {
+	return _words.size();
+}
+
+unsigned int CompactedGraph::getUnitig (const KmerCode &code) const {
+	unsigned int slot = _kmerCount.getSlot(code);
+	if (slot == MinimalPerfectHash::NOT_FOUND) {
+		return NOT_FOUND;
+	}
+	return _unitigIds[slot];
+}
+
+const string &CompactedGraph::getWord (const unsigned int unitig) const {
+	return _words[unitig];
+}
+
+KmerNb CompactedGraph::getCount (const unsigned int unitig) const {
+	return _counts[unitig];
+}
+
+unsigned int CompactedGraph::getEndSlot (const unsigned int unitig, const short position) const {
+	return (position == Globals::BEFORE)? _slots[_starts[unitig]]: _slots[_starts[unitig+1]-1];
+}
+
+KmerNb CompactedGraph::getEndCount (const unsigned int unitig, const short position) const {
+	return _kmerCount.getSlotCount(getEndSlot(unitig, position));
+}
+
+// Gives the (canonical) codes of the k-mers next to the given side of the
+// unitig, the unitigs they belong to, and the direction of the links.
+unsigned int CompactedGraph::getNeighbors (const unsigned int unitig, const short position, KmerCode *codes, unsigned int *unitigs, short *directions) const {
+	unsigned int slot    = getEndSlot(unitig, position);
+	bool         forward = (_ends[unitig] >> position) & 1;
+	short        side    = (forward)? position: 1 - position;
+	unsigned int edges   = _kmerCount.getSlotEdges(slot) >> (side * Globals::NB_NUCLEOTIDES);
+	KmerCode     code    = _kmerCount.getCode(slot);
+	unsigned int n       = 0;
+	for (int nucleotide = 0; nucleotide < Globals::NB_NUCLEOTIDES; nucleotide++) {
+		if (! ((edges >> nucleotide) & 1)) {
+			continue;
+		}
+		KmerCode     nextCode = getNeighbor(code, nucleotide, side);
+		KmerCode     reverse  = getReverseComplement(nextCode);
+		bool         direct   = ! (reverse < nextCode);
+		KmerCode     canonical = (direct)? nextCode: reverse;
+		unsigned int nextSlot = _kmerCount.getSlot(canonical);
+		if (nextSlot == MinimalPerfectHash::NOT_FOUND) {
+			continue;
+		}
+		unsigned int nextUnitig = _unitigIds[nextSlot];
+		short        end        = (getEndSlot(nextUnitig, Globals::BEFORE) == nextSlot)? Globals::BEFORE: Globals::AFTER;
+		codes[n]      = canonical;
+		unitigs[n]    = nextUnitig;
+		directions[n] = ((forward == direct) == static_cast<bool>((_ends[nextUnitig] >> end) & 1))? Globals::DIRECT: Globals::REVERSE;
+		n++;
+	}
+	return n;
+}
+
+void CompactedGraph::remove (const unsigned int unitig) {
+	for (unsigned int i = _starts[unitig]; i < _starts[unitig+1]; i++) {
+		_kmerCount.removeSlot(_slots[i]);
+	}
+}
+
+void CompactedGraph::clear () {
+	_unitigIds.clear();
+	_starts.clear();
+	_slots.clear();
+	_words.clear();
+	_counts.clear();
+	_ends.clear();
+}
+
+KmerCode CompactedGraph::getNeighbor (const KmerCode &code, const int nucleotide, const short position) {
+	if (position == Globals::AFTER) {
+		return ((code << Globals::NB_BITS_NUCLEOTIDES) | KmerCode(nucleotide)) & (Kmer::UNSET >> (Globals::NB_BLOCKS * block_s - Globals::NB_BITS_NUCLEOTIDES * Globals::KMER));
+	}
+	return (KmerCode(nucleotide) << (Globals::NB_BITS_NUCLEOTIDES * (Globals::KMER - 1))) | (code >> Globals::NB_BITS_NUCLEOTIDES);
+}
+
+KmerCode CompactedGraph::getReverseComplement (const KmerCode &code) {
+	KmerCode firstCode = code;
+	KmerCode secondCode(0);
+	for (unsigned int i = 0; i < Globals::KMER; i++) {
+		secondCode <<= Globals::NB_BITS_NUCLEOTIDES;
+		secondCode |= Globals::getComplementCode(firstCode.to_uint() & Globals::NUCLEOTIDE_MASK);
+		firstCode >>= Globals::NB_BITS_NUCLEOTIDES;
+	}
+	return secondCode;
+}
+
+string CompactedGraph::getWord (const KmerCode &code) {
+	KmerCode firstCode = code;
+	string   word(Globals::KMER, 'A');
+	for (unsigned int i = 0; i < Globals::KMER; i++) {
+		word[Globals::KMER - i - 1] = Globals::getNucleotide(firstCode.to_uint() & Globals::NUCLEOTIDE_MASK);
+		firstCode >>= Globals::NB_BITS_NUCLEOTIDES;
+	}
+	return word;
+}
@@ -0,0 +1,64 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef COMPACTED_GRAPH_HPP
+#define COMPACTED_GRAPH_HPP 1
+
+#include <vector>
+#include <string>
+#include "globals.hpp"
+#include "kmerCode.hpp"
+#include "frozenKmerCount.hpp"
+using namespace std;
+
+// Compacted de Bruijn graph, built over the frozen k-mer index.
+// The non-branching paths of k-mers with compatible counts are merged into
+// unitigs.  A unitig is stored as its canonical word, and as the slots of
+// its k-mers, in the order of the word.
+class CompactedGraph {
+
+	private:
+		FrozenKmerCount        &_kmerCount;
+		vector <unsigned int>   _unitigIds;
+		vector <unsigned int>   _starts;
+		vector <unsigned int>   _slots;
+		vector <string>         _words;
+		vector <KmerNb>         _counts;
+		vector <unsigned char>  _ends;
+
+	public:
+		static constexpr unsigned int NOT_FOUND = -1;
+
+		CompactedGraph (FrozenKmerCount &kmerCount);
+		void build ();
+		unsigned int getNbUnitigs () const;
+		unsigned int getUnitig (const KmerCode &code) const;
+		const string &getWord (const unsigned int unitig) const;
+		KmerNb getCount (const unsigned int unitig) const;
+		KmerNb getEndCount (const unsigned int unitig, const short position) const;
+		unsigned int getNeighbors (const unsigned int unitig, const short position, KmerCode *codes, unsigned int *unitigs, short *directions) const;
+		void remove (const unsigned int unitig);
+		void clear ();
+
+	private:
+		unsigned int extend (const unsigned int slot, const short position, short &arrival) const;
+		void addUnitig (vector <unsigned int> &slots, vector <bool> &orientations, string &word, vector <unsigned int> &starts, vector <unsigned int> &allSlots, vector <string> &words, vector <KmerNb> &counts, vector <unsigned char> &ends) const;
+		unsigned int getEndSlot (const unsigned int unitig, const short position) const;
+		static KmerCode getNeighbor (const KmerCode &code, const int nucleotide, const short position);
+		static KmerCode getReverseComplement (const KmerCode &code);
+		static string getWord (const KmerCode &code);
+};
+
+#endif
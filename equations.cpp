@@ -18,15 +18,22 @@ along with this program.
 #endif
 
 #include <cmath>
+#include <limits>
 #include "globals.hpp"
 #include "equations.hpp"
-#include "simplex.hpp"
 
 
+constexpr unsigned int EquationSystem::MAX_ITERATIONS;
+constexpr double       EquationSystem::EPSILON;
+constexpr double       EquationSystem::GAP_TOLERANCE;
+constexpr double       EquationSystem::PATH_PENALTY;
+constexpr double       EquationSystem::DROP_TOLERANCE;
+constexpr unsigned int EquationSystem::REFACTOR_PERIOD;
+
 EquationSystem::EquationSystem(const int nbPathes): _nbPathes(nbPathes), _sizes(_nbPathes, 0) {}
 
-void EquationSystem::addNode(const int nodeId, const KmerNb count) {
-	_equations[nodeId] = Equation(count);
+void EquationSystem::addNode(const int nodeId, const KmerNb count, const unsigned int weight) {
+	_equations[nodeId] = Equation(count, weight);
 }
 
 void EquationSystem::addNodePath(const int pathId, const int nodeId) {
@@ -46,52 +53,278 @@ KmerNb EquationSystem::operator()(vector <KmerNb> &values) {
 	return getScore(values);
 }
 
-void EquationSystem::solveSimplex() {
-	int nbPathes    = _nbPathes;
-	int nbNodes     = _equations.size();
-	int nbVariables = nbNodes + nbPathes;
-	int nbEquations = 2 * nbNodes;
-	Simplex simplex = Simplex(nbEquations, nbVariables);
-	/*
-	vector <int> objective(nbPathes, 0);
-	for (int i = 0; i < _nbPathes; i++) {
-		objective[i] = _sizes[i] * _sizes[i];
+// Minimizes the sum over the nodes of weight * |count - sum of the values
+// of the pathes which contain the node|, with non-negative values.  Among
+// the best solutions, the one with the smallest sum of the values is
+// preferred, so that the counts are explained by the pathes which share the
+// most nodes: PATH_PENALTY times the sum of the values is added to the
+// objective.  The dual of this L1 regression is
+//   max sum_n count_n y_n, with sum_{n in p} y_n <= PATH_PENALTY and
+//   -weight_n <= y_n <= weight_n,
+// which has one row per path, and one column per node (the pathes of the
+// node).  With z_n = y_n + weight_n, it is solved by a bounded-variable simplex,
+// in double precision, starting from z = 0 and the slacks in the basis.
+// The basis inverse is kept in product form: a list of eta columns, the
+// entering columns expressed in the previous basis, which are about as
+// sparse as the pathes of the nodes.  A pivot costs the size of this list,
+// and the basis is factored again from the slacks every REFACTOR_PERIOD
+// pivots.  The values of the pathes are the multipliers of the rows at the
+// optimum.  If the primal and dual scores differ (numerical issue, or
+// iteration limit), the last values are kept, and false is returned.
+bool EquationSystem::solveL1() {
+	vector <vector <unsigned int> > columns;
+	vector <double>                 counts, weights;
+	vector <unsigned int>           pathes;
+	for (Equations::const_iterator it = _equations.begin(); it != _equations.end(); ++it) {
+		pathes = it->second.getPathes();
+		sort(pathes.begin(), pathes.end());
+		pathes.erase(unique(pathes.begin(), pathes.end()), pathes.end());
+		columns.push_back(pathes);
+		counts.push_back(it->second.getNb());
+		weights.push_back(it->second.getWeight());
 	}
-	*/
-	vector <int> objective(nbPathes, 0);
-	vector <int> objective2(nbNodes, -1);
-	objective.insert(objective.end(), objective2.begin(), objective2.end());
-	simplex.addObjective(objective);
-	int i = 0;
-	for (Equations::const_iterator it = _equations.begin(); it != _equations.end(); ++it, i++) {
-		vector <int> line(nbPathes, 0);
-		vector <int> line2(nbPathes, 0);
-		vector <int> line3(nbNodes, 0);
-		const vector <unsigned int> &pathes = it->second.getPathes();
-		for (unsigned int j = 0; j < pathes.size(); j++) {
-			line[pathes[j]] = 1;
-			line2[pathes[j]] = -1;
-		}
-		line3[i] = -1;
-		line.insert(line.end(), line3.begin(), line3.end());
-		line2.insert(line2.end(), line3.begin(), line3.end());
-		simplex.addLine(2 * i, line, it->second.getNb());
-		simplex.addLine(2 * i + 1, line2, - it->second.getNb());
+	unsigned int nbRows       = _nbPathes;
+	unsigned int nbNodes      = columns.size();
+	unsigned int nbColumns    = nbNodes + nbRows;
+	unsigned int maxPivots    = MAX_ITERATIONS + 10 * nbColumns;
+	unsigned int nbDegenerate = 0;
+	unsigned int nbUpdates    = 0;
+	bool         optimal      = false;
+	// the node columns, then the slacks
+	auto getCost = [&](unsigned int j) {
+		return (j < nbNodes)? counts[j]: 0.0;
+	};
+	auto getUpper = [&](unsigned int j) {
+		return (j < nbNodes)? 2 * weights[j]: numeric_limits<double>::infinity();
+	};
+	auto getColumn = [&](unsigned int j, vector <double> &column) {
+		fill(column.begin(), column.end(), 0.0);
+		if (j < nbNodes) {
+			for (unsigned int pathId: columns[j]) {
+				column[pathId] = 1.0;
+			}
+		}
+		else {
+			column[j - nbNodes] = 1.0;
+		}
+	};
+	vector <unsigned int> basis(nbRows);
+	vector <double>       rightHandSide(nbRows, PATH_PENALTY), basicValues, multipliers(nbRows), alpha(nbRows);
+	vector <char>         inBasis(nbColumns, false), atUpper(nbColumns, false);
+	for (unsigned int j = 0; j < nbNodes; j++) {
+		for (unsigned int pathId: columns[j]) {
+			rightHandSide[pathId] += weights[j];
+		}
 	}
-	simplex.setBase();
-	//cout << "Simplex in: " << endl << simplex << endl;
-	simplex.simplex();
-	//cout << "Simplex out: " << endl << simplex << endl;
-	//for (int i = 0; i < nbPathes+nbNodes; i++) {
-	//	cout << simplex.getValue(i) << " ";
-	//}
-	//cout << endl;
-	for (int i = 0; i < nbPathes; i++) {
-		_values.push_back(simplex.getValue(i));
+	for (unsigned int r = 0; r < nbRows; r++) {
+		basis[r]             = nbNodes + r;
+		inBasis[nbNodes + r] = true;
 	}
+	basicValues = rightHandSide;
+	// the eta file: the pivot row and value of each eta column, and its
+	// other non-zero values
+	vector <unsigned int> etaRows, etaStarts(1, 0), etaIndices;
+	vector <double>       etaPivots, etaValues;
+	auto addEta = [&](unsigned int row, const vector <double> &column) {
+		etaRows.push_back(row);
+		etaPivots.push_back(column[row]);
+		for (unsigned int r = 0; r < nbRows; r++) {
+			if ((r != row) && (fabs(column[r]) > DROP_TOLERANCE)) {
+				etaIndices.push_back(r);
+				etaValues.push_back(column[r]);
+			}
+		}
+		etaStarts.push_back(etaIndices.size());
+	};
+	// x := B^-1 x
+	auto forwardSolve = [&](vector <double> &x) {
+		for (unsigned int k = 0; k < etaRows.size(); k++) {
+			double &pivot = x[etaRows[k]];
+			if (pivot != 0.0) {
+				pivot /= etaPivots[k];
+				for (unsigned int e = etaStarts[k]; e < etaStarts[k+1]; e++) {
+					x[etaIndices[e]] -= etaValues[e] * pivot;
+				}
+			}
+		}
+	};
+	// y := y B^-1
+	auto backwardSolve = [&](vector <double> &y) {
+		for (unsigned int k = etaRows.size(); k-- > 0; ) {
+			double value = y[etaRows[k]];
+			for (unsigned int e = etaStarts[k]; e < etaStarts[k+1]; e++) {
+				value -= etaValues[e] * y[etaIndices[e]];
+			}
+			y[etaRows[k]] = value / etaPivots[k];
+		}
+	};
+	// The basic slacks stay in their rows, and each basic node column is
+	// pivoted in the free row where it is the largest.  The basic values are
+	// then computed again from the nonbasic ones.
+	auto refactor = [&]() {
+		vector <unsigned int> nodes;
+		vector <char>         used(nbRows, false);
+		etaRows.clear();
+		etaPivots.clear();
+		etaStarts.assign(1, 0);
+		etaIndices.clear();
+		etaValues.clear();
+		for (unsigned int r = 0; r < nbRows; r++) {
+			if (basis[r] < nbNodes) {
+				nodes.push_back(basis[r]);
+			}
+			else {
+				used[basis[r] - nbNodes] = true;
+			}
+		}
+		for (unsigned int r = 0; r < nbRows; r++) {
+			if (used[r]) {
+				basis[r] = nbNodes + r;
+			}
+		}
+		for (unsigned int j: nodes) {
+			getColumn(j, alpha);
+			forwardSolve(alpha);
+			unsigned int row  = nbRows;
+			double       best = EPSILON;
+			for (unsigned int r = 0; r < nbRows; r++) {
+				if ((! used[r]) && (fabs(alpha[r]) > best)) {
+					row  = r;
+					best = fabs(alpha[r]);
+				}
+			}
+			if (row == nbRows) {
+				return false;
+			}
+			addEta(row, alpha);
+			basis[row] = j;
+			used[row]  = true;
+		}
+		basicValues = rightHandSide;
+		for (unsigned int j = 0; j < nbNodes; j++) {
+			if (atUpper[j]) {
+				for (unsigned int pathId: columns[j]) {
+					basicValues[pathId] -= getUpper(j);
+				}
+			}
+		}
+		forwardSolve(basicValues);
+		nbUpdates = 0;
+		return true;
+	};
+	for (unsigned int pivot = 0; pivot < maxPivots; pivot++) {
+		if ((nbUpdates >= REFACTOR_PERIOD) && (! refactor())) {
+			break;
+		}
+		for (unsigned int r = 0; r < nbRows; r++) {
+			multipliers[r] = getCost(basis[r]);
+		}
+		backwardSolve(multipliers);
+		// Dantzig's rule, or Bland's rule after many degenerate pivots
+		bool         bland    = (nbDegenerate > nbRows + 10);
+		unsigned int entering = nbColumns;
+		double       bestGain = EPSILON;
+		for (unsigned int j = 0; (j < nbColumns) && ((! bland) || (entering == nbColumns)); j++) {
+			if (inBasis[j]) {
+				continue;
+			}
+			double reducedCost = getCost(j);
+			if (j < nbNodes) {
+				for (unsigned int pathId: columns[j]) {
+					reducedCost -= multipliers[pathId];
+				}
+			}
+			else {
+				reducedCost -= multipliers[j - nbNodes];
+			}
+			double gain = (atUpper[j])? -reducedCost: reducedCost;
+			if (gain > bestGain) {
+				entering = j;
+				bestGain = gain;
+			}
+		}
+		if (entering == nbColumns) {
+			optimal = true;
+			break;
+		}
+		getColumn(entering, alpha);
+		forwardSolve(alpha);
+		// ratio test, the entering variable may also go to its other bound
+		double       sign    = (atUpper[entering])? -1.0: 1.0;
+		double       step    = getUpper(entering);
+		unsigned int leaving = nbRows;
+		bool         toUpper = false;
+		for (unsigned int r = 0; r < nbRows; r++) {
+			double delta = sign * alpha[r];
+			if (delta > EPSILON) {
+				double limit = max<double>(basicValues[r], 0.0) / delta;
+				if (limit < step) {
+					step    = limit;
+					leaving = r;
+					toUpper = false;
+				}
+			}
+			else if ((delta < -EPSILON) && (getUpper(basis[r]) != numeric_limits<double>::infinity())) {
+				double limit = max<double>(getUpper(basis[r]) - basicValues[r], 0.0) / -delta;
+				if (limit < step) {
+					step    = limit;
+					leaving = r;
+					toUpper = true;
+				}
+			}
+		}
+		if (step == numeric_limits<double>::infinity()) {
+			break;
+		}
+		nbDegenerate = (step < EPSILON)? nbDegenerate + 1: 0;
+		for (unsigned int r = 0; r < nbRows; r++) {
+			basicValues[r] -= step * sign * alpha[r];
+		}
+		if (leaving == nbRows) {
+			atUpper[entering] = ! atUpper[entering];
+			continue;
+		}
+		unsigned int left    = basis[leaving];
+		inBasis[left]        = false;
+		atUpper[left]        = toUpper;
+		inBasis[entering]    = true;
+		basis[leaving]       = entering;
+		basicValues[leaving] = (atUpper[entering])? getUpper(entering) - step: step;
+		atUpper[entering]    = false;
+		addEta(leaving, alpha);
+		nbUpdates++;
+	}
+	// optimality check: the primal score is the dual one
+	vector <double> values(nbRows);
+	for (unsigned int r = 0; r < nbRows; r++) {
+		values[r] = max<double>(multipliers[r], 0.0);
+	}
+	vector <double> z(nbColumns, 0.0);
+	for (unsigned int j = 0; j < nbColumns; j++) {
+		z[j] = (atUpper[j])? getUpper(j): 0.0;
+	}
+	for (unsigned int r = 0; r < nbRows; r++) {
+		z[basis[r]] = basicValues[r];
+	}
+	double primal = 0.0, dual = 0.0;
+	for (unsigned int r = 0; r < nbRows; r++) {
+		primal += PATH_PENALTY * values[r];
+	}
+	for (unsigned int j = 0; j < nbNodes; j++) {
+		double sum = 0.0;
+		for (unsigned int pathId: columns[j]) {
+			sum += values[pathId];
+		}
+		primal += weights[j] * fabs(counts[j] - sum);
+		dual   += counts[j] * (z[j] - weights[j]);
+	}
+	_values.clear();
+	for (unsigned int i = 0; i < nbRows; i++) {
+		_values.push_back(static_cast<KmerNb>(round(values[i])));
+	}
+	return ((optimal) && (fabs(primal - dual) <= GAP_TOLERANCE * (1.0 + fabs(primal))));
 }
 
-
 KmerNb EquationSystem::getValue(int index) const {
 	return _values[index];
 }
@@ -20,6 +20,7 @@ along with this program.
 #include <iostream>
 #include <map>
 #include <vector>
+#include <algorithm>
 using namespace std;
 
 
@@ -27,17 +28,22 @@ class Equation {
 
 	private:
 		KmerNb               _count;
+		unsigned int         _weight;
 		vector<unsigned int> _pathes;
 
 	public:
 		Equation () {}
 
-		Equation (const KmerNb c): _count(c) {}
+		Equation (const KmerNb c, const unsigned int w = 1): _count(c), _weight(w) {}
 
 		KmerNb getNb() const {
 			return _count;
 		}
 
+		unsigned int getWeight() const {
+			return _weight;
+		}
+
 		const vector <unsigned int> &getPathes() const {
 			return _pathes;
 		}
@@ -51,7 +57,7 @@ class Equation {
 			for (unsigned int i = 0; i < _pathes.size(); i++) {
 				score += values[_pathes[i]];
 			}
-			return static_cast<KmerNb>((_count > score)? _count - score: score - _count);
+			return _weight * static_cast<KmerNb>((_count > score)? _count - score: score - _count);
 		}
 };
 
@@ -61,6 +67,13 @@ typedef map<int, Equation> Equations;
 class EquationSystem {
 
 	private:
+		static constexpr unsigned int MAX_ITERATIONS  = 1000;
+		static constexpr double       EPSILON         = 1e-9;
+		static constexpr double       GAP_TOLERANCE   = 1e-6;
+		static constexpr double       PATH_PENALTY    = 1e-6;
+		static constexpr double       DROP_TOLERANCE  = 1e-12;
+		static constexpr unsigned int REFACTOR_PERIOD = 100;
+
 		Equations            _equations;
 		int                  _nbPathes;
 		vector <KmerNb>      _values;
@@ -69,12 +82,12 @@ class EquationSystem {
 
 	public:
 		EquationSystem (const int nbPathes);
-		void addNode(const int nodeId, const KmerNb count);
+		void addNode(const int nodeId, const KmerNb count, const unsigned int weight = 1);
 		void addNodePath(const int pathId, const int nodeId);
 		KmerNb getScore(vector <KmerNb> &values);
 		KmerNb operator()(vector <KmerNb> &values);
 		void fillSystem();
-		void solveSimplex();
+		bool solveL1();
 		
 		KmerNb getValue(int index) const;
 
@@ -99,9 +99,7 @@ string &FastxParser::getWord() {
 }
 
 Sequence &FastxParser::getSequence() {
-	if (_sequence.empty()) {
-		getNextKmer();
-	}
+	_sequence.setFirstWord(getWord());
 	return _sequence;
 }
 
@@ -124,7 +122,6 @@ void FastxParser::findNextKmer() {
 			_word += _line[_pos];
 			_pos++;
 		}
-		_sequence = Sequence(_word);
 	}
 }
 
@@ -133,7 +130,7 @@ void FastxParser::findNextCheckedKmer() {
 		findNextKmer();
 	}
 	//while ((not isOver()) && (_sequence.isAmbiguous()));
-	while ((not isOver()) && ((_sequence.isAmbiguous()) || (_sequence.isLowComplexity())));
+	while ((not isOver()) && ((Sequence::isAmbiguous(_word)) || (Sequence::isLowComplexity(_word))));
 }
 
 void FastxParser::readNewLine() {
@@ -0,0 +1,276 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thread>
+#include "frozenKmerCount.hpp"
+
+constexpr unsigned int FrozenKmerCount::BATCH_SIZE;
+
+FrozenKmerCount::FrozenKmerCount (): _size(0), _next(0) { }
+
+void FrozenKmerCount::build (const SimpleKmerCount &kmerCount) {
+	vector <KmerCode> codes;
+	vector <KmerNb>   counts;
+	kmerCount.getKmers(codes, counts);
+	clear();
+	_hash.build(codes);
+	unsigned int size      = codes.size();
+	unsigned int nbBits    = Globals::NB_BITS_NUCLEOTIDES * Globals::KMER;
+	unsigned int nbThreads = max<int>(Globals::NB_THREADS, 1);
+	KmerNb       maxCount  = 0;
+	unsigned int countBits = 1;
+	for (KmerNb count: counts) {
+		maxCount = max<KmerNb>(maxCount, count);
+	}
+	while ((countBits < 64) && ((maxCount >> countBits) != 0)) {
+		countBits++;
+	}
+	_codes.resize((nbBits + 63) / 64);
+	for (unsigned int block = 0; block < _codes.size(); block++) {
+		_codes[block].resize(size, min<unsigned int>(64, nbBits - 64 * block));
+	}
+	_counts.resize(size, countBits);
+	_consumed = vector <atomic <uint64_t> > (size / 64 + 1);
+	for (unsigned int i = 0; i < _consumed.size(); i++) {
+		_consumed[i] = 0;
+	}
+	vector <unsigned int> order(size);
+	vector <thread>       threads;
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int i = threadId; i < size; i += nbThreads) {
+				order[_hash.lookup(codes[i])] = i;
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	threads.clear();
+	// Each thread fills a range of slots, aligned on 64 slots so that no word is shared.
+	unsigned int nbChunks  = (size + 63) / 64;
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			unsigned int start = static_cast<unsigned long>(nbChunks) * threadId / nbThreads * 64;
+			unsigned int end   = min<unsigned int>(size, static_cast<unsigned long>(nbChunks) * (threadId + 1) / nbThreads * 64);
+			for (unsigned int slot = start; slot < end; slot++) {
+				const KmerCode &code = codes[order[slot]];
+				for (unsigned int block = 0; block < _codes.size(); block++) {
+					_codes[block].set(slot, code.getBlock(block));
+				}
+				_counts.set(slot, counts[order[slot]]);
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	_size = size;
+	_next = 0;
+}
+
+unsigned int FrozenKmerCount::getSlot (const KmerCode &code) const {
+	unsigned int slot = _hash.lookup(code);
+	if ((slot == MinimalPerfectHash::NOT_FOUND) || (getCode(slot) != code)) {
+		return MinimalPerfectHash::NOT_FOUND;
+	}
+	return slot;
+}
+
+KmerCode FrozenKmerCount::getCode (const unsigned int slot) const {
+	KmerCode code(0);
+	for (unsigned int block = 0; block < _codes.size(); block++) {
+		code.setBlock(block, _codes[block].get(slot));
+	}
+	return code;
+}
+
+bool FrozenKmerCount::isConsumed (const unsigned int slot) const {
+	return ((_consumed[slot / 64] >> (slot % 64)) & 1);
+}
+
+KmerNb FrozenKmerCount::getCount (const Kmer &kmer) const {
+	if (! kmer.isSet()) {
+		return 0;
+	}
+	return getCount(kmer.getFirstCode());
+}
+
+KmerNb FrozenKmerCount::getCount (const KmerCode &code) const {
+	if (! _filter.contains(code)) {
+		return 0;
+	}
+	unsigned int slot = getSlot(code);
+	if ((slot == MinimalPerfectHash::NOT_FOUND) || (isConsumed(slot))) {
+		return 0;
+	}
+	return _counts.get(slot);
+}
+
+// The queries are processed in three passes: the k-mers which pass the Bloom
+// filter have the first bit arrays of the hash function prefetched, then the slots are computed and their codes and counts
+// are prefetched, and finally the codes are checked.
+void FrozenKmerCount::getCounts (const KmerCode *codes, const unsigned int n, KmerNb *counts, unsigned char *edges) const {
+	unsigned int slots[BATCH_SIZE];
+	for (unsigned int start = 0; start < n; start += BATCH_SIZE) {
+		unsigned int size = min<unsigned int>(n - start, BATCH_SIZE);
+		for (unsigned int i = 0; i < size; i++) {
+			if (_filter.contains(codes[start+i])) {
+				slots[i] = 0;
+				__builtin_prefetch(_hash.getFirstAddress(codes[start+i]));
+			}
+			else {
+				slots[i] = MinimalPerfectHash::NOT_FOUND;
+			}
+		}
+		for (unsigned int i = 0; i < size; i++) {
+			if (slots[i] == MinimalPerfectHash::NOT_FOUND) {
+				continue;
+			}
+			slots[i] = _hash.lookup(codes[start+i]);
+			if (slots[i] != MinimalPerfectHash::NOT_FOUND) {
+				for (const PackedArray &code: _codes) {
+					__builtin_prefetch(code.getAddress(slots[i]));
+				}
+				__builtin_prefetch(_counts.getAddress(slots[i]));
+				if (edges != nullptr) {
+					__builtin_prefetch(&_edges[slots[i]]);
+				}
+			}
+		}
+		for (unsigned int i = 0; i < size; i++) {
+			unsigned int slot  = slots[i];
+			bool         found = ((slot != MinimalPerfectHash::NOT_FOUND) && (getCode(slot) == codes[start+i]));
+			counts[start+i] = ((found) && (! isConsumed(slot)))? _counts.get(slot): 0;
+			if (edges != nullptr) {
+				edges[start+i] = (found)? _edges[slot]: 0;
+			}
+		}
+	}
+}
+
+unsigned char FrozenKmerCount::getEdges (const KmerCode &code) const {
+	unsigned int slot = getSlot(code);
+	return (slot == MinimalPerfectHash::NOT_FOUND)? 0: _edges[slot];
+}
+
+void FrozenKmerCount::remove (const KmerCode &kmerCode) {
+	unsigned int slot = getSlot(kmerCode);
+	if (slot == MinimalPerfectHash::NOT_FOUND) {
+		return;
+	}
+	removeSlot(slot);
+}
+
+unsigned int FrozenKmerCount::getNbSlots () const {
+	return _hash.getSize();
+}
+
+KmerNb FrozenKmerCount::getSlotCount (const unsigned int slot) const {
+	return _counts.get(slot);
+}
+
+unsigned char FrozenKmerCount::getSlotEdges (const unsigned int slot) const {
+	return _edges[slot];
+}
+
+void FrozenKmerCount::removeSlot (const unsigned int slot) {
+	uint64_t bit = static_cast<uint64_t>(1) << (slot % 64);
+	if ((_consumed[slot / 64].fetch_or(bit) & bit) == 0) {
+		--_size;
+	}
+}
+
+pair <KmerCode, KmerNb> FrozenKmerCount::getRandom () {
+	for (; _next < _hash.getSize(); _next++) {
+		if (! isConsumed(_next)) {
+			return make_pair(getCode(_next), _counts.get(_next));
+		}
+	}
+	return make_pair(Kmer::UNSET, 0);
+}
+
+bool FrozenKmerCount::empty () const {
+	return (_size == 0);
+}
+
+unsigned int FrozenKmerCount::getSize () const {
+	return _size;
+}
+
+void FrozenKmerCount::buildFilter () {
+	unsigned int    size      = _hash.getSize();
+	unsigned int    nbThreads = max<int>(Globals::NB_THREADS, 1);
+	vector <thread> threads;
+	_filter.resize(size);
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int slot = threadId; slot < size; slot += nbThreads) {
+				_filter.add(getCode(slot));
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+}
+
+void FrozenKmerCount::buildEdges () {
+	unsigned int    size      = _hash.getSize();
+	unsigned int    nbThreads = max<int>(Globals::NB_THREADS, 1);
+	vector <thread> threads;
+	_edges.assign(size, 0);
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int slot = threadId; slot < size; slot += nbThreads) {
+				Kmer kmer(getCode(slot));
+				for (short position = 0; position < Globals::POSITIONS; position++) {
+					for (short nucleotide = 0; nucleotide < Globals::NB_NUCLEOTIDES; nucleotide++) {
+						if (getSlot(kmer.getCodeNeighbor(nucleotide, position)) != MinimalPerfectHash::NOT_FOUND) {
+							_edges[slot] |= 1 << (position * Globals::NB_NUCLEOTIDES + nucleotide);
+						}
+					}
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+}
+
+unsigned long FrozenKmerCount::getMemory () const {
+	unsigned long memory = _hash.getMemory() + _counts.getMemory() + _filter.getMemory() + _edges.size() + _consumed.size() * sizeof(uint64_t);
+	for (const PackedArray &codes: _codes) {
+		memory += codes.getMemory();
+	}
+	return memory;
+}
+
+void FrozenKmerCount::clear () {
+	_hash.clear();
+	_filter.clear();
+	_codes.clear();
+	_counts.clear();
+	_edges.clear();
+	_edges.shrink_to_fit();
+	_consumed.clear();
+	_size = 0;
+	_next = 0;
+}
@@ -0,0 +1,71 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef FROZEN_KMER_COUNT_HPP
+#define FROZEN_KMER_COUNT_HPP 1
+
+#include <atomic>
+#include <vector>
+#include "globals.hpp"
+#include "kmer.hpp"
+#include "kmerCount.hpp"
+#include "simpleKmerCount.hpp"
+#include "minimalPerfectHash.hpp"
+#include "packedArray.hpp"
+using namespace std;
+
+// Static k-mer table, built once the k-mer set is fixed.
+// Each k-mer gets a slot from a minimal perfect hash function.
+// The codes (used to discard absent k-mers) and the counts are bit-packed.
+// A removed k-mer is only flagged as consumed.
+class FrozenKmerCount: public KmerCount {
+
+	private:
+		static constexpr unsigned int BATCH_SIZE = 64;
+
+		MinimalPerfectHash         _hash;
+		vector <PackedArray>       _codes;
+		PackedArray                _counts;
+		vector <unsigned char>     _edges;
+		vector <atomic <uint64_t> > _consumed;
+		atomic <unsigned int>      _size;
+		unsigned int               _next;
+
+	public:
+		FrozenKmerCount ();
+		void build (const SimpleKmerCount &kmerCount);
+		KmerNb getCount (const Kmer &kmer) const;
+		KmerNb getCount (const KmerCode &code) const;
+		void getCounts (const KmerCode *codes, const unsigned int n, KmerNb *counts, unsigned char *edges = nullptr) const;
+		unsigned char getEdges (const KmerCode &code) const;
+		void remove (const KmerCode &kmerCode);
+		pair <KmerCode, KmerNb> getRandom ();
+		bool empty () const;
+		unsigned int getSize () const;
+		void buildFilter ();
+		void buildEdges ();
+		unsigned long getMemory () const;
+		void clear ();
+
+		unsigned int getNbSlots () const;
+		unsigned int getSlot (const KmerCode &code) const;
+		KmerCode getCode (const unsigned int slot) const;
+		KmerNb getSlotCount (const unsigned int slot) const;
+		unsigned char getSlotEdges (const unsigned int slot) const;
+		bool isConsumed (const unsigned int slot) const;
+		void removeSlot (const unsigned int slot);
+};
+
+#endif
@@ -25,6 +25,8 @@ unsigned int   Globals::BUBBLE_SIZE              = 1000;
 int            Globals::MIN_LTR_SIZE             = 50;
 int            Globals::MAX_LTR_SIZE             = 5000;
 unsigned short Globals::SHORT_KMER_SIZE          = 15;
+unsigned int   Globals::MIN_SHARED_SEEDS         = 1;
+unsigned int   Globals::SKETCH_SCALE             = 1;
 Penalty        Globals::MAX_MERGE_SIZE           = 500;
 Penalty        Globals::MIN_MERGE_SIZE           = 20;
 Penalty        Globals::PENALTY_SIZE             = 1;
@@ -39,4 +41,8 @@ unsigned long  Globals::MIN_SCAFFOLD_KMERS       = 10;
 unsigned long  Globals::MAX_SCAFFOLD_COUNTS      = 10000000;
 unsigned int   Globals::SCAFFOLD_MAX_EV          = 5;
 bool           Globals::FASTA_INPUT              = false;
+bool           Globals::FROZEN_INDEX             = false;
+bool           Globals::UNITIGS                  = false;
+bool           Globals::OVERLAP_INDEX            = false;
+bool           Globals::CONTAINMENT_FILTER       = false;
 string         Globals::CHECK;
@@ -59,6 +59,8 @@ class Globals {
 		static int            MIN_LTR_SIZE;
 		static int            MAX_LTR_SIZE;
 		static unsigned short SHORT_KMER_SIZE;
+		static unsigned int   MIN_SHARED_SEEDS;
+		static unsigned int   SKETCH_SCALE;
 		static Penalty        MAX_MERGE_SIZE;
 		static Penalty        MIN_MERGE_SIZE;
 		static Penalty        PENALTY_SIZE;
@@ -73,6 +75,10 @@ class Globals {
 		static unsigned long  MAX_SCAFFOLD_COUNTS;
 		static unsigned int   SCAFFOLD_MAX_EV;
 		static bool           FASTA_INPUT;
+		static bool           FROZEN_INDEX;
+		static bool           UNITIGS;
+		static bool           OVERLAP_INDEX;
+		static bool           CONTAINMENT_FILTER;
 		static string         CHECK;
 
 		static char getComplement(const char c) {
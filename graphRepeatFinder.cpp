@@ -20,51 +20,39 @@ along with this program.
 #include <cstdlib>
 #include <set>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <sstream>
 #include "globals.hpp"
 #include "graphRepeatFinder.hpp"
 #include "graphTrimmer.hpp"
 
-GraphRepeatFinder::GraphRepeatFinder(SimpleKmerCount &km, const KmerNb threshold): _kmerCount(km), _threshold(threshold) {}
+constexpr unsigned int GraphRepeatFinder::BATCH_SIZE;
+constexpr unsigned int GraphRepeatFinder::NB_NEIGHBORS;
+
+GraphRepeatFinder::GraphRepeatFinder(KmerCount &km, const KmerNb threshold, CompactedGraph *compactedGraph): _kmerCount(km), _threshold(threshold), _frozenKmerCount(dynamic_cast<FrozenKmerCount*>(&km)), _compactedGraph(compactedGraph), _output(&cout) {
+	if (_compactedGraph != nullptr) {
+		_unitigNodes.assign(_compactedGraph->getNbUnitigs(), CompactedGraph::NOT_FOUND);
+	}
+}
 
 void GraphRepeatFinder::findRepeats () {
+	if (_frozenKmerCount != nullptr) {
+		findComponentRepeats();
+		return;
+	}
 	//cout << "Finding repeats..." << endl;
 	unsigned int nbSmall         = 0;
 	unsigned int initialHashSize = _kmerCount.getSize();
 	while (! _kmerCount.empty()) {
 		//cout << "Finding most repeated k-mer..." << endl;
-		Kmer firstKmer(getFirstKmer());
+		KmerCode firstCode = getFirstKmer();
 		//cout << "  done: " << firstKmer << endl;
-		//cout << "Building graph..." << endl;
-		SequenceGraph graph;
-		fillFirstGraph(graph, firstKmer);
-		//cout << "First graph: \n" << graph << endl;
-		if (graph.isSmall()) {
-			if (! Globals::CHECK.empty() && graph.check()) {
-				cout << "\t\t\tSequence is in small graph of size " << graph.getSize() << endl;
-			}
-			//cout << "\t...graph is small" << endl;
-			removeKmers();
-			nbSmall++;
+		if (findRepeat(firstCode)) {
+			nbSmall = 0;
 		}
 		else {
-			//cout << "\t...graph is not small" << endl;
-			//SequenceGraph bestGraph = findBestGraph(firstGraph);
-			if (graph.isBig()) {
-				if (! Globals::CHECK.empty() && graph.check()) {
-					cout << "\t\t\tSequence is in big graph" << endl;
-				}
-				graph.findGreedyPathes();
-			}
-			else {
-				if (! Globals::CHECK.empty()) {
-					graph.check();
-				}
-				build(graph);
-			}
-			//decreaseKmers(bestGraph);
-			removeKmers();
-			addRepeats(graph);
-			nbSmall = 0;
+			nbSmall++;
 		}
 		//cout << "  done." << endl;
 		//if (i % 10 == 0) {
@@ -84,6 +72,199 @@ void GraphRepeatFinder::findRepeats () {
 	//gatherRepeats();
 }
 
+// Build and solve the graph which starts with the given k-mer.
+// Return false iff the graph is small.
+bool GraphRepeatFinder::findRepeat (const KmerCode &firstCode) {
+	//cout << "Building graph..." << endl;
+	SequenceGraph graph;
+	bool          truncated;
+	if (_compactedGraph == nullptr) {
+		truncated = fillFirstGraph(graph, Kmer(firstCode));
+	}
+	else {
+		truncated = fillUnitigGraph(graph, _compactedGraph->getUnitig(firstCode));
+	}
+	//cout << "First graph: \n" << graph << endl;
+	if ((! truncated) && (graph.isSmall())) {
+		if (! Globals::CHECK.empty() && graph.check()) {
+			*_output << "\t\t\tSequence is in small graph of size " << graph.getSize() << endl;
+		}
+		//cout << "\t...graph is small" << endl;
+		removeKmers();
+		return false;
+	}
+	//cout << "\t...graph is not small" << endl;
+	//SequenceGraph bestGraph = findBestGraph(firstGraph);
+	if ((truncated) || (graph.isBig())) {
+		if (! Globals::CHECK.empty() && graph.check()) {
+			*_output << "\t\t\tSequence is in big graph" << endl;
+		}
+		graph.findGreedyPathes();
+	}
+	else {
+		if (! Globals::CHECK.empty()) {
+			graph.check();
+		}
+		build(graph);
+	}
+	//decreaseKmers(bestGraph);
+	removeKmers();
+	addRepeats(graph);
+	return true;
+}
+
+// With the frozen index, the k-mers are first split into connected
+// components.  The components which cannot give a large graph are discarded
+// at once, and the other ones are solved in parallel, largest first.
+// The graphs never cross components, so each component is processed as the
+// whole table would be.
+// The workers do not print their progress: their messages are kept per
+// component, and printed in order once they are done.
+void GraphRepeatFinder::findComponentRepeats () {
+	vector <unsigned int> starts, slots;
+	findComponents(starts, slots);
+	unsigned int          nbComponents = starts.size() - 1;
+	vector <unsigned int> components;
+	unsigned long         nbSmall      = 0;
+	for (unsigned int component = 0; component < nbComponents; component++) {
+		unsigned int size = starts[component+1] - starts[component];
+		if ((Globals::CHECK.empty()) && (static_cast<int>(size + Globals::KMER - 1) < Globals::MIN_NB_NODES)) {
+			for (unsigned int i = starts[component]; i < starts[component+1]; i++) {
+				_frozenKmerCount->removeSlot(slots[i]);
+			}
+			nbSmall++;
+		}
+		else {
+			components.push_back(component);
+		}
+	}
+	stable_sort(components.begin(), components.end(), [&starts](unsigned int c1, unsigned int c2) {
+		return (starts[c1+1] - starts[c1] > starts[c2+1] - starts[c2]);
+	});
+	cout << "\tFound " << nbComponents << " components, " << nbSmall << " of them discarded as small." << endl;
+	unsigned int      nbThreads = max<int>(Globals::NB_THREADS, 1);
+	vector <Repeats>  repeats(components.size());
+	vector <string>   outputs(components.size());
+	atomic <unsigned> next(0);
+	vector <thread>   threads;
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&]() {
+			GraphRepeatFinder finder(_kmerCount, _threshold, _compactedGraph);
+			for (unsigned int i = next++; i < components.size(); i = next++) {
+				unsigned int  component = components[i];
+				ostringstream output;
+				finder._output = &output;
+				for (unsigned int j = starts[component]; j < starts[component+1]; j++) {
+					unsigned int slot = slots[j];
+					if ((! _frozenKmerCount->isConsumed(slot)) && (_frozenKmerCount->getSlotCount(slot) >= _threshold)) {
+						finder.findRepeat(_frozenKmerCount->getCode(slot));
+					}
+				}
+				swap(repeats[i], finder._repeats);
+				outputs[i] = output.str();
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	for (const string &output: outputs) {
+		cout << output;
+	}
+	for (const Repeats &r: repeats) {
+		_repeats.addRepeats(r);
+	}
+}
+
+// Parallel union-find over the slots of the frozen index.  Two k-mers are
+// joined when a graph may be extended from one to the other, in any way.
+// The slots of each component are given in increasing order, the component
+// c being slots[starts[c]..starts[c+1]).
+void GraphRepeatFinder::findComponents (vector <unsigned int> &starts, vector <unsigned int> &slots) {
+	unsigned int               nbSlots   = _frozenKmerCount->getNbSlots();
+	unsigned int               nbThreads = max<int>(Globals::NB_THREADS, 1);
+	vector <atomic <unsigned> > parents(nbSlots);
+	vector <thread>            threads;
+	auto find = [&parents](unsigned int slot) {
+		unsigned int parent = parents[slot];
+		while (parent != slot) {
+			unsigned int grandParent = parents[parent];
+			parents[slot].compare_exchange_weak(parent, grandParent);
+			slot   = grandParent;
+			parent = parents[slot];
+		}
+		return slot;
+	};
+	auto compatible = [](KmerNb count, KmerNb nextCount) {
+		return ((nextCount >= count / Globals::FREQUENCY_DIFFERENCE) && (nextCount <= count * Globals::FREQUENCY_DIFFERENCE));
+	};
+	for (unsigned int slot = 0; slot < nbSlots; slot++) {
+		parents[slot] = slot;
+	}
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int slot = threadId; slot < nbSlots; slot += nbThreads) {
+				KmerNb        count = _frozenKmerCount->getSlotCount(slot);
+				unsigned char edges = _frozenKmerCount->getSlotEdges(slot);
+				if ((count < _threshold) || (edges == 0)) {
+					continue;
+				}
+				Kmer kmer(_frozenKmerCount->getCode(slot));
+				for (unsigned int neighbor = 0; neighbor < NB_NEIGHBORS; neighbor++) {
+					if (! (edges & (1 << neighbor))) {
+						continue;
+					}
+					unsigned int nextSlot = _frozenKmerCount->getSlot(kmer.getCodeNeighbor(neighbor % Globals::NB_NUCLEOTIDES, neighbor / Globals::NB_NUCLEOTIDES));
+					if ((nextSlot <= slot) || (nextSlot == MinimalPerfectHash::NOT_FOUND)) {
+						continue;
+					}
+					KmerNb nextCount = _frozenKmerCount->getSlotCount(nextSlot);
+					if ((nextCount < _threshold) || ((! compatible(count, nextCount)) && (! compatible(nextCount, count)))) {
+						continue;
+					}
+					// The larger root is linked to the smaller one, so that no cycle appears.
+					unsigned int root1 = slot, root2 = nextSlot;
+					while (true) {
+						root1 = find(root1);
+						root2 = find(root2);
+						if (root1 == root2) {
+							break;
+						}
+						if (root1 < root2) {
+							swap(root1, root2);
+						}
+						unsigned int expected = root1;
+						if (parents[root1].compare_exchange_strong(expected, root2)) {
+							break;
+						}
+					}
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	vector <unsigned int> ids(nbSlots, CompactedGraph::NOT_FOUND);
+	starts.assign(1, 0);
+	for (unsigned int slot = 0; slot < nbSlots; slot++) {
+		unsigned int root = find(slot);
+		if (root == slot) {
+			ids[slot] = starts.size() - 1;
+			starts.push_back(0);
+		}
+		starts[ids[root]+1]++;
+	}
+	for (unsigned int component = 1; component < starts.size(); component++) {
+		starts[component] += starts[component-1];
+	}
+	vector <unsigned int> positions(starts.begin(), starts.end() - 1);
+	slots.resize(nbSlots);
+	for (unsigned int slot = 0; slot < nbSlots; slot++) {
+		slots[positions[ids[find(slot)]]++] = slot;
+	}
+}
+
 KmerCode GraphRepeatFinder::getFirstKmer () {
 	pair <KmerCode, KmerNb> p;
 	do {
@@ -93,52 +274,153 @@ KmerCode GraphRepeatFinder::getFirstKmer () {
 	return p.first;
 }
 
-void GraphRepeatFinder::fillFirstGraph (SequenceGraph &graph, const Kmer &firstKmer) {
-	vector < int > indices;
-	Sequence      firstSequence = firstKmer.getSequence();
-	KmerNb        firstCount    = _kmerCount.getCount(firstKmer);
-	KmerCode      firstCode     = firstKmer.getFirstCode();
+// The nodes on top of the stack are expanded by batches: the counts of all
+// their neighbors are fetched at once.  Only the neighbors given by the edge
+// masks are queried.
+// No node is added once the graph is bigger than allowed: the nodes of the
+// stack are only linked to the known nodes, and the other k-mers are left
+// for the next graphs.  Return true iff the graph has been truncated.
+bool GraphRepeatFinder::fillFirstGraph (SequenceGraph &graph, const Kmer &firstKmer) {
+	vector < int >           indices;
+	vector < int >           batch;
+	vector < Kmer >          batchKmers;
+	vector < unsigned char > kmerEdges;
+	KmerCode                 nextCodes[BATCH_SIZE * NB_NEIGHBORS];
+	KmerNb                   nextCounts[BATCH_SIZE * NB_NEIGHBORS];
+	unsigned char            nextEdges[BATCH_SIZE * NB_NEIGHBORS];
+	unsigned int             nextIds[BATCH_SIZE * NB_NEIGHBORS];
+	Sequence                 firstSequence = firstKmer.getSequence();
+	KmerNb                   firstCount    = _kmerCount.getCount(firstKmer);
+	KmerCode                 firstCode     = firstKmer.getFirstCode();
 	//cout << "Inserting nodes..." << endl;
 	graph.addNode(0, firstCount, firstSequence);
 	_kmers.clear();
+	_kmerIds.clear();
 	indices.push_back(0);
 	_kmers.push_back(firstCode);
+	_kmerIds[firstCode] = 0;
+	kmerEdges.push_back(_kmerCount.getEdges(firstCode));
+	bool truncated = false;
 	while (! indices.empty()) {
-		int currentIndex         = indices.back();
-		SequenceNode currentNode = graph.getNode(currentIndex);
-		KmerCode currentCode     = _kmers[currentIndex];
-		Kmer currentKmer         = Kmer(currentCode);
-		KmerNb currentCount      = _kmerCount.getCount(currentKmer);
+		unsigned int batchSize = min<unsigned int>(indices.size(), BATCH_SIZE);
+		unsigned int nbQueries = 0;
+		batch.assign(indices.rbegin(), indices.rbegin() + batchSize);
+		indices.resize(indices.size() - batchSize);
+		batchKmers.clear();
+		for (unsigned int i = 0; i < batchSize; i++) {
+			batchKmers.push_back(Kmer(_kmers[batch[i]]));
+			for (unsigned int neighbor = 0; neighbor < NB_NEIGHBORS; neighbor++) {
+				if (kmerEdges[batch[i]] & (1 << neighbor)) {
+					nextCodes[nbQueries] = batchKmers[i].getCodeNeighbor(neighbor % Globals::NB_NUCLEOTIDES, neighbor / Globals::NB_NUCLEOTIDES);
+					nextIds[nbQueries]   = i * NB_NEIGHBORS + neighbor;
+					nbQueries++;
+				}
+			}
+		}
+		_kmerCount.getCounts(nextCodes, nbQueries, nextCounts, nextEdges);
+		for (unsigned int query = 0; query < nbQueries; query++) {
+			unsigned int i            = nextIds[query] / NB_NEIGHBORS;
+			short        position     = (nextIds[query] % NB_NEIGHBORS) / Globals::NB_NUCLEOTIDES;
+			int          currentIndex = batch[i];
+			Kmer        &currentKmer  = batchKmers[i];
+			KmerNb       currentCount = graph.getNode(currentIndex).getCount();
+			KmerCode     nextCode     = nextCodes[query];
+			KmerNb       nextCount    = nextCounts[query];
+			auto it = _kmerIds.find(nextCode);
+			if (it != _kmerIds.end()) {
+				graph.addLink(currentIndex, position, currentKmer.compare(Kmer(nextCode), position), it->second);
+			}
+			else if ((nextCode != Kmer::UNSET) && (nextCount >= _threshold) && (nextCount >= currentCount / Globals::FREQUENCY_DIFFERENCE) && (nextCount <= currentCount * Globals::FREQUENCY_DIFFERENCE)) {
+			//else if ((nextKmer.isSet()) && (nextCount >= _threshold)) {
+				if (_kmers.size() > Globals::MAX_NB_NODES) {
+					truncated = true;
+					continue;
+				}
+				//cout << "Adding " << currentKmer << " <-> " << nextKmer <<  " (position: " << position << ")" << endl;
+				Kmer nextKmer(nextCode);
+				int  nextIndex = _kmers.size();
+				graph.addNode(nextIndex, nextCount, nextKmer.getSequence());
+				indices.push_back(nextIndex);
+				graph.addLink(currentIndex, position, currentKmer.compare(nextKmer, position), nextIndex);
+				_kmers.push_back(nextCode);
+				_kmerIds[nextCode] = nextIndex;
+				kmerEdges.push_back(nextEdges[query]);
+				if ((_output == &cout) && (_kmers.size() % 1000 == 0)) {
+					cout << "\tBuilding graph with " << _kmers.size() << " nodes explored and " << indices.size() << " in stack.    ";
+					cout << string(80, '\b') << flush;
+				}
+			}
+		}
+	}
+	if (truncated) {
+		*_output << "\tBuilt graph with " << _kmers.size() << " nodes (truncated).                             " << endl; 
+	}
+	else if (! graph.isSmall()) {
+		*_output << "\tBuilt graph with " << _kmers.size() << " nodes.                                         " << endl; 
+	}
+	return truncated;
+}
+
+// Same as above, but the nodes are unitigs.  The counts of the k-mers at the
+// ends of the unitigs are used to decide whether the neighbors are added.
+bool GraphRepeatFinder::fillUnitigGraph (SequenceGraph &graph, const unsigned int firstUnitig) {
+	vector < int > indices;
+	KmerCode       nextCodes[Globals::NB_NUCLEOTIDES];
+	KmerNb         nextCounts[Globals::NB_NUCLEOTIDES];
+	unsigned int   nextUnitigs[Globals::NB_NUCLEOTIDES];
+	short          nextDirections[Globals::NB_NUCLEOTIDES];
+	unsigned long  nbKmers   = 0;
+	bool           truncated = false;
+	for (unsigned int unitig: _unitigs) {
+		_unitigNodes[unitig] = CompactedGraph::NOT_FOUND;
+	}
+	_unitigs.clear();
+	graph.addNode(0, _compactedGraph->getCount(firstUnitig), Sequence(_compactedGraph->getWord(firstUnitig)));
+	indices.push_back(0);
+	_unitigs.push_back(firstUnitig);
+	_unitigNodes[firstUnitig] = 0;
+	nbKmers += _compactedGraph->getWord(firstUnitig).size() - Globals::KMER + 1;
+	while (! indices.empty()) {
+		int          currentIndex  = indices.back();
+		unsigned int currentUnitig = _unitigs[currentIndex];
 		indices.pop_back();
 		for (short position = 0; position < Globals::POSITIONS; position++) {
-			for (short nucleotide = 0; nucleotide < Globals::NB_NUCLEOTIDES; nucleotide++) {
-				Kmer nextKmer(currentKmer.getCodeNeighbor(nucleotide, position));
-				KmerNb   nextCount    = _kmerCount.getCount(nextKmer);
-				KmerCode nextCode     = nextKmer.getFirstCode();
-				short    direction    = currentKmer.compare(nextKmer, position);
-				auto it = find(_kmers.begin(), _kmers.end(), nextCode);
-				if (it != _kmers.end()) {
-					graph.addLink(currentIndex, position, direction, it - _kmers.begin());
+			KmerNb       currentCount = _compactedGraph->getEndCount(currentUnitig, position);
+			unsigned int nbNeighbors  = _compactedGraph->getNeighbors(currentUnitig, position, nextCodes, nextUnitigs, nextDirections);
+			_kmerCount.getCounts(nextCodes, nbNeighbors, nextCounts);
+			for (unsigned int neighbor = 0; neighbor < nbNeighbors; neighbor++) {
+				unsigned int nextUnitig = nextUnitigs[neighbor];
+				KmerNb       nextCount  = nextCounts[neighbor];
+				if (_unitigNodes[nextUnitig] != CompactedGraph::NOT_FOUND) {
+					graph.addLink(currentIndex, position, nextDirections[neighbor], _unitigNodes[nextUnitig]);
 				}
-				else if ((nextKmer.isSet()) && (nextCount >= _threshold) && (nextCount >= currentCount / Globals::FREQUENCY_DIFFERENCE) && (nextCount <= currentCount * Globals::FREQUENCY_DIFFERENCE)) {
-				//else if ((nextKmer.isSet()) && (nextCount >= _threshold)) {
-					//cout << "Adding " << currentKmer << " <-> " << nextKmer <<  " (position: " << position << ", nucleotide: " << nucleotide << ")" << endl;
-					int nextIndex = _kmers.size();
-					graph.addNode(nextIndex, nextCount, nextKmer.getSequence());
+				else if ((nextCount >= _threshold) && (nextCount >= currentCount / Globals::FREQUENCY_DIFFERENCE) && (nextCount <= currentCount * Globals::FREQUENCY_DIFFERENCE)) {
+					if (nbKmers > Globals::MAX_NB_NODES) {
+						truncated = true;
+						continue;
+					}
+					int nextIndex = _unitigs.size();
+					graph.addNode(nextIndex, _compactedGraph->getCount(nextUnitig), Sequence(_compactedGraph->getWord(nextUnitig)));
 					indices.push_back(nextIndex);
-					graph.addLink(currentIndex, position, direction, nextIndex);
-					_kmers.push_back(nextCode);
+					graph.addLink(currentIndex, position, nextDirections[neighbor], nextIndex);
+					_unitigs.push_back(nextUnitig);
+					_unitigNodes[nextUnitig] = nextIndex;
+					nbKmers += _compactedGraph->getWord(nextUnitig).size() - Globals::KMER + 1;
+					if ((_output == &cout) && (_unitigs.size() % 1000 == 0)) {
+						cout << "\tBuilding graph with " << _unitigs.size() << " unitigs explored and " << indices.size() << " in stack.    ";
+						cout << string(80, '\b') << flush;
+					}
 				}
 			}
 		}
-		if (_kmers.size() % 1000 == 0) {
-			cout << "\tBuilding graph with " << _kmers.size() << " nodes explored and " << indices.size() << " in stack.    ";
-			cout << string(80, '\b') << flush;
-		}
 	}
-	if (! graph.isSmall()) {
-		cout << "\tBuilt graph with " << _kmers.size() << " nodes.                                         " << endl; 
+	if (truncated) {
+		*_output << "\tBuilt graph with " << _unitigs.size() << " unitigs (" << nbKmers << " k-mers, truncated).                   " << endl; 
+	}
+	else if (! graph.isSmall()) {
+		*_output << "\tBuilt graph with " << _unitigs.size() << " unitigs (" << nbKmers << " k-mers).                              " << endl; 
 	}
+	return truncated;
 }
 
 /*
@@ -254,6 +536,12 @@ void GraphRepeatFinder::build(SequenceGraph &graph) {
 }
 
 void GraphRepeatFinder::removeKmers() {
+	if (_compactedGraph != nullptr) {
+		for (unsigned int unitig: _unitigs) {
+			_compactedGraph->remove(unitig);
+		}
+		return;
+	}
 	for (KmerCode &code: _kmers) {
 		_kmerCount.remove(code);
 	}
@@ -277,15 +565,18 @@ void GraphRepeatFinder::solveProblem(SequenceGraph &graph) {
 			nodeIds.insert(graph.getNode(paths[i].getNode(j)).getId());
 		}
 	}
+	// each node weighs its number of k-mers, as if it were not merged
 	for (unsigned int nodeId: nodeIds) {
-		equations.addNode(nodeId, graph.getNode(nodeId).getCount());
+		equations.addNode(nodeId, graph.getNode(nodeId).getCount(), graph.getNode(nodeId).getNbKmers());
 	}
 	for (unsigned int i = 0; i < paths.size(); i++) {
 		for (unsigned int j = 0; j < paths[i].getSize(); j++) {
 			equations.addNodePath(i, graph.getNode(paths[i].getNode(j)).getId());
 		}
 	}
-	equations.solveSimplex();
+	if (! equations.solveL1()) {
+		*_output << "\t\tWarning! The abundances of the " << paths.size() << " pathes may not be optimal." << endl;
+	}
 	for (unsigned int i = 0; i < paths.size(); i++) {
 		paths[i].setCount(equations.getValue(i));
 	}
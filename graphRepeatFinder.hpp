@@ -17,7 +17,10 @@ along with this program.
 #define GRAPH_REPEAT_FINDER_HPP 1
 
 #include <iostream>
-#include "simpleKmerCount.hpp"
+#include <unordered_map>
+#include "kmerCount.hpp"
+#include "frozenKmerCount.hpp"
+#include "compactedGraph.hpp"
 #include "repeats.hpp"
 #include "sequenceGraph.hpp"
 #include "equations.hpp"
@@ -26,20 +29,32 @@ using namespace std;
 class GraphRepeatFinder {
 
     private:
-		SimpleKmerCount       &_kmerCount;
+		static constexpr unsigned int BATCH_SIZE   = 16;
+		static constexpr unsigned int NB_NEIGHBORS = Globals::POSITIONS * Globals::NB_NUCLEOTIDES;
+
+		KmerCount             &_kmerCount;
 		KmerNb                 _threshold;
+		FrozenKmerCount       *_frozenKmerCount;
 		vector <KmerCode>      _kmers;
+		unordered_map <KmerCode, unsigned int> _kmerIds;
+		CompactedGraph        *_compactedGraph;
+		vector <unsigned int>  _unitigs;
+		vector <unsigned int>  _unitigNodes;
 		Repeats                _repeats;
+		ostream               *_output;
 
     public:
-        GraphRepeatFinder (SimpleKmerCount &km, const KmerNb treshold);
+        GraphRepeatFinder (KmerCount &km, const KmerNb treshold, CompactedGraph *compactedGraph = nullptr);
         void findRepeats ();
 		Repeats &getRepeats ();
 
 	private:
 		KmerCode getFirstKmer ();
-		void findRepeat (const Kmer &findKmer);
-		void fillFirstGraph (SequenceGraph &graph, const Kmer &firstKmer);
+		bool findRepeat (const KmerCode &firstCode);
+		void findComponentRepeats ();
+		void findComponents (vector <unsigned int> &starts, vector <unsigned int> &slots);
+		bool fillFirstGraph (SequenceGraph &graph, const Kmer &firstKmer);
+		bool fillUnitigGraph (SequenceGraph &graph, const unsigned int firstUnitig);
 		//SequenceGraph findBestGraph (SequenceGraph &firstGraph);
 		void build(SequenceGraph &graph);
 		void removeKmers ();
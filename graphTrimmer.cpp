@@ -20,36 +20,92 @@ along with this program.
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include <queue>
 #include "globals.hpp"
 #include "graphTrimmer.hpp"
 
 
-GraphTrimmer::GraphTrimmer(SequenceGraph &graph): _graph(graph) {}
+GraphTrimmer::GraphTrimmer(SequenceGraph &graph): _graph(graph), _visit(0) {}
 
 void GraphTrimmer::trim(bool merge) {
 	//cout << "Starting with\n" << _graph;
-	bool changed;
-	do {
+	ArenaVector <unsigned int> nodes;
+	_graph.freeze();
+	_dirty.assign(_graph.getSize(), false);
+	_visits.assign(_graph.getSize(), 0);
+	_origins.resize(_graph.getSize());
+	_sides.resize(_graph.getSize());
+	_visit = 0;
+	_worklist.clear();
+	for (unsigned int i = 0; i < _graph.getSize(); i++) {
+		if (_graph.getNode(i).isSet()) {
+			touch(i);
+		}
+	}
+	while (! _worklist.empty()) {
+		nodes.swap(_worklist);
+		_worklist.clear();
+		for (unsigned int i: nodes) {
+			_dirty[i] = false;
+		}
 		if (merge) {
-			mergeNodes();
+			mergeNodes(nodes);
 		}
 		//cout << "Now\n" << _graph;
-		pinchBubbles();
-		changed = fuseTips();
-		if (removeTips()) changed = true;
+		pinchBubbles(nodes);
+		fuseTips(nodes);
+		removeTips(nodes);
 	}
-	while (changed);
 	//cout << "Ending with\n" << _graph;
 }
 
+void GraphTrimmer::touch(unsigned int i) {
+	if (! _dirty[i]) {
+		_dirty[i] = true;
+		_worklist.push_back(i);
+	}
+}
+
+// The status of a node depends on its neighbors, and on whether their own
+// neighbors are leaves.
+void GraphTrimmer::touchNeighbors(unsigned int i) {
+	const SequenceNode node = _graph.getNode(i);
+	for (short position = 0; position < Globals::POSITIONS; position++) {
+		for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
+			for (int n = 0; n < node.getNbNeighbors(position, direction); n++) {
+				unsigned int       index    = node.getNeighbor(position, direction, n);
+				const SequenceNode neighbor = _graph.getNode(index);
+				if (neighbor.isSet()) {
+					touch(index);
+					for (short p = 0; p < Globals::POSITIONS; p++) {
+						for (short d = 0; d < Globals::DIRECTIONS; d++) {
+							for (int m = 0; m < neighbor.getNbNeighbors(p, d); m++) {
+								unsigned int k = neighbor.getNeighbor(p, d, m);
+								if (_graph.getNode(k).isSet()) {
+									touch(k);
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void GraphTrimmer::unset(unsigned int i) {
+	_graph.getNode(i).unset();
+	touchNeighbors(i);
+}
+
 /*
 void GraphTrimmer::removeHubs() {
 	unsigned int dummyIndex = _graph.getSize();
 	_graph.addNode(_graph.getSize(), 0);
-	SequenceNode &dummyNode = _graph.getNode(dummyIndex);
+	SequenceNode dummyNode = _graph.getNode(dummyIndex);
 	dummyNode.unset();
 	for (unsigned int i = 0; i < dummyIndex; i++) {
-		SequenceNode &node = _graph.getNode(i);
+		SequenceNode node = _graph.getNode(i);
 		if (node.isSet()) {
 			for (short position = 0; position < Globals::POSITIONS; position++) {
 				if (node.isHub(position)) {
@@ -57,7 +113,7 @@ void GraphTrimmer::removeHubs() {
 					for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
 						for (int ni = 0; ni < node.getNbNeighbors(position, direction); ni++) {
 							unsigned int neighborIndex = node.getNeighbor(position, direction, ni);
-							SequenceNode &neighbor = _graph.getNode(neighborIndex);
+							SequenceNode neighbor = _graph.getNode(neighborIndex);
 							neighbor.updateLinks(i, dummyIndex, true);
 						}
 					}
@@ -68,7 +124,7 @@ void GraphTrimmer::removeHubs() {
 		}
 	}
 	for (unsigned int i = 0; i < dummyIndex; i++) {
-		SequenceNode &node = _graph.getNode(i);
+		SequenceNode node = _graph.getNode(i);
 		if (node.isSet()) {
 			for (short position = 0; position < Globals::POSITIONS; position++) {
 				for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
@@ -89,19 +145,19 @@ void GraphTrimmer::removeHubs() {
 }
 */
 
-void GraphTrimmer::mergeNodes() {
-	//cout << "Merging " << _graph.getSize() << " nodes..." << endl;
+void GraphTrimmer::mergeNodes(const ArenaVector <unsigned int> &nodes) {
+	//cout << "Merging " << nodes.size() << " nodes..." << endl;
 	//cout << _graph << endl;
 	int nbMerges = 0;
 	vector <unsigned int> toBeMerged;
-	for (unsigned int i = 0; i < _graph.getSize(); i++) {
+	for (unsigned int i: nodes) {
 		if (_graph.getNode(i).isSet()) {
 			toBeMerged.push_back(i);
 		}
 	}
 	while (! toBeMerged.empty()) {
 		unsigned int  i  = toBeMerged.back();
-		SequenceNode &n1 = _graph.getNode(i);
+		SequenceNode n1 = _graph.getNode(i);
 		toBeMerged.pop_back();
 		if (n1.isSet()) {
 			bool merged = false;
@@ -113,7 +169,7 @@ void GraphTrimmer::mergeNodes() {
 				for (short d = 0; (d < Globals::DIRECTIONS) && (nbNeigbors < 2); d++) {
 					for (int neighbor = 0; (neighbor < n1.getNbNeighbors(position, d)) && (nbNeigbors < 2); neighbor++) {
 						int   id2              = n1.getNeighbor(position, d, neighbor);
-						const SequenceNode &n2 = _graph.getNode(id2);
+						const SequenceNode n2 = _graph.getNode(id2);
 						if (n2.isSet()) {
 							j = id2;
 							direction = d;
@@ -122,12 +178,12 @@ void GraphTrimmer::mergeNodes() {
 					}
 				}
 				if ((nbNeigbors == 1) && (i != j)) {
-					SequenceNode &n2 = _graph.getNode(j);
+					SequenceNode n2 = _graph.getNode(j);
 					nbNeigbors = 0;
 					short otherPosition = (direction == Globals::DIRECT)? 1-position: position;
 					for (short d = 0; (d < Globals::DIRECTIONS) && (nbNeigbors < 2); d++) {
 						for (int neighbor = 0; (neighbor < n2.getNbNeighbors(otherPosition, d)) && (nbNeigbors < 2); neighbor++) {
-							const SequenceNode &n3 = _graph.getNode(n2.getNeighbor(otherPosition, d, neighbor));
+							const SequenceNode n3 = _graph.getNode(n2.getNeighbor(otherPosition, d, neighbor));
 							if (n3.isSet()) {
 								nbNeigbors++;
 							}
@@ -151,7 +207,7 @@ void GraphTrimmer::mergeNodes() {
 									for (int n = 0; n < n2.getNbNeighbors(p, d); n++) {
 										unsigned int k = n2.getNeighbor(p, d, n);
 										if (k != i) {
-											SequenceNode &n3 = _graph.getNode(k);
+											SequenceNode n3 = _graph.getNode(k);
 											if (n3.isSet()) {
 												//cout << "\tNodes of " << k << " were : " << _graph.getNode(k);
 												n3.updateLinks(j, i, (direction == Globals::DIRECT));
@@ -162,6 +218,8 @@ void GraphTrimmer::mergeNodes() {
 								}
 							}
 							n2.unset();
+							touch(i);
+							touchNeighbors(i);
 							nbMerges++;
 							toBeMerged.push_back(i);
 							merged = true;
@@ -175,15 +233,15 @@ void GraphTrimmer::mergeNodes() {
 	//cout << _graph << endl;
 }
 
-void GraphTrimmer::pinchBubbles() {
-	//cout << "Finding bubbles (graph size is " << _graph.getSize() << ")..." << endl;
+void GraphTrimmer::pinchBubbles(const ArenaVector <unsigned int> &nodes) {
+	//cout << "Finding bubbles (" << nodes.size() << " nodes)..." << endl;
 	if (_graph.getSize() < 3) {
 		return;
 	}
 	int nbBubbles = 0;
 	bool bubble;
-	for (unsigned int i = 0; i < _graph.getSize(); i++) {
-		const SequenceNode &node = _graph.getNode(i);
+	for (unsigned int i: nodes) {
+		const SequenceNode node = _graph.getNode(i);
 		do {
 			bubble = false;
 			if (node.isSet()) {
@@ -197,11 +255,9 @@ void GraphTrimmer::pinchBubbles() {
 					else {
 						positionArray = {positions};
 					}
-					SequencePath path(i);
 					for (short position: positionArray) {
 						//cout << "Starting bubbles with " << i << " " << position << endl;
-						if (pinchBubbles(path, position, false)) {
-							pinchBubble(path);
+						if (pinchBubble(i, position)) {
 							bubble = true;
 							nbBubbles++;
 						}
@@ -214,57 +270,73 @@ void GraphTrimmer::pinchBubbles() {
 	//cout << _graph << endl;
 }
 
-bool GraphTrimmer::pinchBubbles(SequencePath &path, short position, bool change) {
-	if (_graph.getCumulatedSize(path) > Globals::BUBBLE_SIZE) {
-		return false;
+// Breadth-first search from the branches of the vee node, up to the bubble
+// size.  When two branches reach the same node on the same side, the branch
+// with the lowest count is removed.
+bool GraphTrimmer::pinchBubble(unsigned int i, short position) {
+	static const unsigned int                  none = static_cast<unsigned int>(-1);
+	queue <pair <unsigned int, unsigned int> > nodes;
+	const SequenceNode                         node = _graph.getNode(i);
+	_visit++;
+	_visits[i]  = _visit;
+	_origins[i] = none;
+	for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
+		for (int n = 0; n < node.getNbNeighbors(position, direction); n++) {
+			unsigned int       index     = node.getNeighbor(position, direction, n);
+			const SequenceNode nextNode  = _graph.getNode(index);
+			unsigned int       size      = nextNode.getSize();
+			if ((nextNode.isSet()) && (_visits[index] != _visit) && (size <= Globals::BUBBLE_SIZE)) {
+				_visits[index]  = _visit;
+				_origins[index] = index;
+				_sides[index]   = (direction == Globals::DIRECT)? position: 1-position;
+				nodes.push(make_pair(index, size));
+			}
+		}
 	}
-	unsigned int  firstIndex = path.getNode(0);
-	unsigned int  lastIndex  = path.getLastNode();
-	SequenceNode &lastNode   = _graph.getNode(lastIndex);
-	for (short p = 0; p < Globals::DIRECTIONS; p++) {
-		if ((p == position) || ((! change) && (path.getSize() > 2))) {
-			for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
-				for (int i = 0; i < lastNode.getNbNeighbors(p, direction); i++) {
-					unsigned int nextIndex = lastNode.getNeighbor(p, direction, i);
-					//cout << "ni: " << nextIndex << ", n-2: " << path.getNode(path.getSize()-2) << endl;
-					const SequenceNode &nextNode = _graph.getNode(nextIndex);
-					if (nextNode.isSet()) {
-						//cout << "\tContinuing bubble with " << path << " and change " << change << ", added " << nextIndex << endl;
-						if ((nextIndex == firstIndex) && ((change) || (p != position))) {
-							//cout << "\t\tFound bubble in path " << path << endl;
-							return true;
+	while (! nodes.empty()) {
+		unsigned int       index    = nodes.front().first;
+		unsigned int       size     = nodes.front().second;
+		unsigned int       origin   = _origins[index];
+		short              side     = _sides[index];
+		const SequenceNode lastNode = _graph.getNode(index);
+		nodes.pop();
+		for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
+			for (int n = 0; n < lastNode.getNbNeighbors(side, direction); n++) {
+				unsigned int       nextIndex = lastNode.getNeighbor(side, direction, n);
+				const SequenceNode nextNode  = _graph.getNode(nextIndex);
+				short              nextSide  = (direction == Globals::DIRECT)? side: 1-side;
+				unsigned int       nextSize  = size + nextNode.getSize() - (Globals::KMER-1);
+				if ((! nextNode.isSet()) || (nextIndex == i)) {
+					continue;
+				}
+				if (_visits[nextIndex] == _visit) {
+					unsigned int otherOrigin = _origins[nextIndex];
+					if ((otherOrigin != origin) && (otherOrigin != none) && (_sides[nextIndex] == nextSide)) {
+						//cout << "\t\tFound bubble from " << i << " through " << origin << " and " << otherOrigin << endl;
+						if ((otherOrigin != nextIndex) && (_graph.getNode(otherOrigin).getCount() < _graph.getNode(origin).getCount())) {
+							unset(otherOrigin);
 						}
-						else if (! path.contains(nextIndex)) {
-							path.addNode(nextIndex);
-							if (pinchBubbles(path, (direction == Globals::DIRECT)? p: 1-p, (change) || (p != position))) {
-								return true;
-							}
-							path.removeLastNode();
+						else {
+							unset(origin);
 						}
+						return true;
 					}
 				}
+				else if (nextSize <= Globals::BUBBLE_SIZE) {
+					_visits[nextIndex]  = _visit;
+					_origins[nextIndex] = origin;
+					_sides[nextIndex]   = nextSide;
+					nodes.push(make_pair(nextIndex, nextSize));
+				}
 			}
 		}
 	}
 	return false;
 }
 
-void GraphTrimmer::pinchBubble(SequencePath &path) {
-	int    index = 0;
-	KmerNb count = -1;
-	for (unsigned int i = 0; i < path.getSize(); i++) {
-		if (_graph.getNode(path.getNode(i)).getCount() < count) {
-			index = i;
-		}
-	}
-	_graph.getNode(path.getNode(index)).unset();
-	//cout << "\t\t\tPinching node " << path.getNode(index) << endl;
-}
-
-bool GraphTrimmer::fuseTips() {
-	bool fused = false;
-	for (unsigned int i = 0; i < _graph.getSize(); i++) {
-		const SequenceNode &node = _graph.getNode(i);
+void GraphTrimmer::fuseTips(const ArenaVector <unsigned int> &nodes) {
+	for (unsigned int i: nodes) {
+		const SequenceNode node = _graph.getNode(i);
 		if (node.isSet()) {
 			int fork =_graph.isVee(node);
 			if (fork > 0) {
@@ -277,14 +349,13 @@ bool GraphTrimmer::fuseTips() {
 					positionArray = {positions};
 				}
 				for (short position: positionArray) {
-					fused = fused || fuseTips(node, position);
+					fuseTips(node, position);
 				}
 			}
 		}
 	}
 	//cout << "Tip fusing done" << endl;
 	//cout << _graph << endl;
-	return fused;
 }
 
 bool GraphTrimmer::fuseTips(const SequenceNode &node, short position) {
@@ -293,7 +364,7 @@ bool GraphTrimmer::fuseTips(const SequenceNode &node, short position) {
 	for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
 		for (int i = 0; i < node.getNbNeighbors(position, direction); i++) {
 			int index = node.getNeighbor(position, direction, i);
-			const SequenceNode &nextNode = _graph.getNode(index);
+			const SequenceNode nextNode = _graph.getNode(index);
 			if (nextNode.isSet()) {
 				if ((! _graph.isLeaf(nextNode)) || (node == nextNode)) {
 					return false;
@@ -311,10 +382,10 @@ bool GraphTrimmer::fuseTips(const SequenceNode &node, short position) {
 		for (int i = 0; i < node.getNbNeighbors(position, direction); i++) {
 			unsigned int index = node.getNeighbor(position, direction, i);
 			if (index != longestNode) {
-				SequenceNode &nextNode = _graph.getNode(index);
+				SequenceNode nextNode = _graph.getNode(index);
 				if (nextNode.isSet()) {
 					//cout << "\t\t\tFusing node " << nextNode << endl;
-					nextNode.unset();
+					unset(index);
 					fused = true;
 				}
 			}
@@ -323,21 +394,19 @@ bool GraphTrimmer::fuseTips(const SequenceNode &node, short position) {
 	return fused;
 }
 
-bool GraphTrimmer::removeTips() {
-	bool removed = false;
-	for (unsigned int i = 0; i < _graph.getSize(); i++) {
-		const SequenceNode &node = _graph.getNode(i);
+void GraphTrimmer::removeTips(const ArenaVector <unsigned int> &nodes) {
+	for (unsigned int i: nodes) {
+		const SequenceNode node = _graph.getNode(i);
 		if (node.isSet()) {
 			int fork =_graph.isFork(node);
 			if (fork > 0) {
 				short position = fork - 1;
-				removed = removed || removeTips(node, position);
+				removeTips(node, position);
 			}
 		}
 	}
 	//cout << "Tip removal done" << endl;
 	//cout << _graph << endl;
-	return removed;
 }
 
 bool GraphTrimmer::removeTips(const SequenceNode &node, short position) {
@@ -346,7 +415,7 @@ bool GraphTrimmer::removeTips(const SequenceNode &node, short position) {
 	for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
 		for (int i = 0; i < node.getNbNeighbors(position, direction); i++) {
 			int index = node.getNeighbor(position, direction, i);
-			const SequenceNode &nextNode = _graph.getNode(index);
+			const SequenceNode nextNode = _graph.getNode(index);
 			if (nextNode.isSet()) {
 				if ((! _graph.isLeaf(nextNode)) || (node == nextNode)) {
 					return false;
@@ -373,7 +442,9 @@ bool GraphTrimmer::removeTips(const SequenceNode &node, short position) {
 			unsigned int index = node.getNeighbor(position, direction, i);
 			if (index != longestNode) {
 				//cout << "\t\t\tRemoving node " << _graph.getNode(index) << endl;
-				_graph.getNode(index).unset();
+				if (_graph.getNode(index).isSet()) {
+					unset(index);
+				}
 				removed = true;
 			}
 		}
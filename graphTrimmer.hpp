@@ -25,10 +25,18 @@ along with this program.
 using namespace std;
 
 
+// The trimmer keeps a worklist of the nodes whose neighborhood has changed,
+// and only examines these nodes until the graph is stable.
 class GraphTrimmer {
 
     private:
 		SequenceGraph &_graph;
+		ArenaVector <unsigned int> _worklist;
+		ArenaVector <bool>         _dirty;
+		unsigned int               _visit;
+		ArenaVector <unsigned int> _visits;
+		ArenaVector <unsigned int> _origins;
+		ArenaVector <short>        _sides;
 
     public:
         GraphTrimmer (SequenceGraph &graph);
@@ -36,13 +44,15 @@ class GraphTrimmer {
 		//void removeHubs ();
 
 	private:
-		void mergeNodes ();
-		void pinchBubbles ();
-		bool pinchBubbles (SequencePath &path, short position, bool change);
-		void pinchBubble (SequencePath &path);
-		bool fuseTips ();
+		void touch (unsigned int i);
+		void touchNeighbors (unsigned int i);
+		void unset (unsigned int i);
+		void mergeNodes (const ArenaVector <unsigned int> &nodes);
+		void pinchBubbles (const ArenaVector <unsigned int> &nodes);
+		bool pinchBubble (unsigned int i, short position);
+		void fuseTips (const ArenaVector <unsigned int> &nodes);
 		bool fuseTips (const SequenceNode &node, short position);
-		bool removeTips ();
+		void removeTips (const ArenaVector <unsigned int> &nodes);
 		bool removeTips (const SequenceNode &node, short position);
 };
 
@@ -17,82 +17,97 @@ along with this program.
 #include <config.h>
 #endif
 
-#include <thread>
-#include <mutex>
+#include <cstdint>
+#include <cmath>
+#include <atomic>
 #include "globals.hpp"
 #include "inclusionRemover.hpp"
+#include "pairScheduler.hpp"
 
-InclusionRemover::InclusionRemover(const Repeats &repeats): _kmerSets(repeats.getNbRepeats()), _repeats(repeats) { }
+InclusionRemover::InclusionRemover(const Repeats &repeats): _repeats(repeats) { }
 
+// The repeats are sorted, longest first.  Each repeat i is compared to the
+// shorter repeats which share enough seeds with it.  The pairs are given by
+// the seed index, so the scheduler hands out the rows in order, and applies
+// their inclusions in this order.  The removals are flagged, and applied at
+// the end.
 void InclusionRemover::removeInclusions () {
 	cout << "Removing duplicates (" << _repeats.getNbRepeats() << " elements)..." << endl;
 	_repeats.sort();
-	storeKmers();
-	unsigned int i = 0, j = 1, cpt = 0, nbInclusions = 0;
-	vector <thread> threads(Globals::NB_THREADS);
-	mutex m1, m2;
-	for (int threadId = 0; threadId < Globals::NB_THREADS; threadId++) {
-		threads[threadId] = thread([this, &i, &j, &cpt, &nbInclusions, &m1, &m2]() {
-			unsigned int thisI, thisJ, thisCpt, nbRepeats = _repeats.getNbRepeats();
-			while (true) {
-				{
-					lock_guard<mutex> lock(m1);
-					thisI = i;
-					thisJ = j;
-					do {
-						j++;
-						if (j >= nbRepeats) {
-							i++;
-							j = i+1;
-						}
-					}
-					while ((j < nbRepeats) && ((_repeats.isRemoved(i)) || (_repeats.isRemoved(j))));
-					cpt++;
-					thisCpt = cpt;
-				}
-				if (thisJ >= nbRepeats) {
-					return;
-				}
-				if ((! _repeats.isRemoved(thisI)) && (! _repeats.isRemoved(thisJ))) {
-					if (checkInclusion(thisI, thisJ)) {
-						lock_guard<mutex> lock(m2);
-						nbInclusions++;
-						_repeats.removeRepeat(thisJ);
-					}
-				}
-				if (thisCpt % 100000 == 0) {
-					cout << "\t" << thisCpt << " duplications evaluated." << endl;
-				}
-			}
-		});
+	_seedIndex.build(_repeats);
+	unsigned int                    nbRepeats = _repeats.getNbRepeats();
+	unsigned int                    nbThreads = max<int>(Globals::NB_THREADS, 1);
+	PairScheduler                   scheduler(nbRepeats, nbThreads);
+	vector <unsigned int>           minShared(nbRepeats);
+	vector <vector <unsigned int> > counts(nbThreads);
+	atomic <unsigned long>          cpt(0);
+	unsigned int                    nbInclusions = 0;
+	for (unsigned int i = 0; i < nbRepeats; i++) {
+		if (_repeats.isRemoved(i)) {
+			scheduler.remove(i);
+		}
+		minShared[i] = getMinShared(i);
 	}
-	for (int threadId = 0; threadId < Globals::NB_THREADS; threadId++) {
-		threads[threadId].join();
+	scheduler.runRows([&](unsigned int threadId, unsigned int i, vector <unsigned int> &inclusions) {
+		vector <unsigned int> candidates;
+		string                firstString;
+		if (counts[threadId].empty()) {
+			counts[threadId].resize(nbRepeats, 0);
+		}
+		_seedIndex.getCandidates(i, minShared, counts[threadId], candidates);
+		for (unsigned int j: candidates) {
+			if (scheduler.isRemoved(i)) {
+				break;
+			}
+			if (scheduler.isRemoved(j)) {
+				continue;
+			}
+			if (firstString.empty()) {
+				firstString = _repeats.getRepeat(i).getRepeat().getFirstWord();
+			}
+			if (checkInclusion(firstString, j)) {
+				inclusions.push_back(j);
+			}
+			if (++cpt % 100000 == 0) {
+				cout << "\t" << cpt << " duplications evaluated." << endl;
+			}
+		}
+	});
+	_seedIndex.clear();
+	for (unsigned int i = 0; i < nbRepeats; i++) {
+		if ((scheduler.isRemoved(i)) && (! _repeats.isRemoved(i))) {
+			_repeats.removeRepeat(i);
+			nbInclusions++;
+		}
 	}
 	cout << "\t" << cpt << " duplications evaluated, " << nbInclusions << " found." << endl;
 	_repeats.sort();
 	//cout << *this << endl;
 }
 
-void InclusionRemover::storeKmers () {
-	for (unsigned int i = 0; i < _repeats.getNbRepeats(); i++) {
-		if (! _repeats.isRemoved(i)) {
-			_kmerSets[i].setSequence(_repeats[i].getRepeat().getFirstWord());
-			//cout << "\tStoring kmers[" << i << "]:" << _kmerSets[i] << endl;
-		}
+// With a divergence d, a k-mer of a repeat is kept in the other one with a
+// probability of about (1 - d)^k.  The fraction of the seeds of the repeat
+// which are shared with another one (its containment, estimated on the
+// sketches) should then be at least (1 - MAX_IDENTITY)^k, otherwise the
+// estimated divergence is above MAX_IDENTITY.  (The q-gram lemma gives
+// no bound here: MAX_IDENTITY errors may destroy all the k-mers.)
+// This is the expected containment, not a lower bound: about half of the
+// duplicates close to MAX_IDENTITY are below it, so the filter is only used
+// with CONTAINMENT_FILTER.  Otherwise, any MIN_SHARED_SEEDS shared seeds are
+// enough.
+unsigned int InclusionRemover::getMinShared (const unsigned int i) const {
+	if (! Globals::CONTAINMENT_FILTER) {
+		return Globals::MIN_SHARED_SEEDS;
 	}
+	double containment = pow(1.0 - Globals::MAX_IDENTITY, Globals::SHORT_KMER_SIZE);
+	return max<unsigned int>(static_cast<unsigned int>(_seedIndex.getNbSeeds(i) * containment), Globals::MIN_SHARED_SEEDS);
 }
 
-bool InclusionRemover::checkInclusion (const unsigned int i, const unsigned int j) const {
-	//cout << "\tInspecting " << i << " vs " << j << endl;
-	if (! _kmerSets[i].compare(_kmerSets[j])) {
-		//cout << "\t\tNo kmer in common." << endl;
-		return false;
-	}
-	//cout << "\t\tSome kmers in common." << endl;
-	const string &firstString = _repeats.getRepeat(i).getRepeat().getFirstWord();
+// The first string is the repeat of the row, which is decoded once for all
+// its candidates.
+bool InclusionRemover::checkInclusion (const string &firstString, const unsigned int j) const {
 	for (short int direction = 0; direction < Globals::DIRECTIONS; direction++) {
-		const string &secondString = _repeats.getRepeat(j).getRepeat().getWord(direction);
+		string secondString = _repeats.getRepeat(j).getRepeat().getWord(direction);
 		bool   included            = compareStrings(secondString, firstString);
 		if (included) {
 			//cout << secondString << " seems included into " << firstString << endl;
@@ -102,37 +117,70 @@ bool InclusionRemover::checkInclusion (const unsigned int i, const unsigned int
 	return false;
 }
 
+// Semi-global edit distance: the first string should be entirely aligned
+// with a part of the second string, with less than MAX_IDENTITY differences
+// per nucleotide.
+// The column of the dynamic programming table is stored as vertical
+// differences in words of 64 bits (Myers' bit-vector algorithm, in its
+// multi-word version).  The last cell changes by at most one per
+// character of the second string, which gives an early stop.
 bool InclusionRemover::compareStrings(const string &firstString, const string &secondString) const {
-	//cout << "Entering compareStrings" << endl;
-	unsigned int firstSize = firstString.size(), secondSize = secondString.size();
-	vector < int > line(firstSize+1);
-	int current, tmp;
-	int maxPenalty = firstSize * Globals::MAX_IDENTITY;
-	//cout << "\t\tfirst string: " << firstString << ", second string: " << secondString << ", max penalty: " << maxPenalty << endl;
-	for (unsigned int i = 1; i <= firstSize; i++) {
-		line[i] = i;
+	unsigned int firstSize  = firstString.size(), secondSize = secondString.size();
+	int          maxPenalty = firstSize * Globals::MAX_IDENTITY;
+	if ((firstSize == 0) || (maxPenalty <= 0)) {
+		return false;
 	}
-	for (unsigned int i = 1; i <= secondSize; i++) {
-		current = 0;
-		for (unsigned int j = 1; j <= firstSize; j++) {
-			tmp = line[j];
-			try {
-				line[j] = min<int>(min<int>(current + ((secondString[i-1]==firstString[j-1])? 0: 1), line[j-1]+1), line[j]+1);
+	unsigned int     nbWords = (firstSize + 63) / 64;
+	uint64_t         lastBit = static_cast<uint64_t>(1) << ((firstSize - 1) % 64);
+	uint64_t         highBit = static_cast<uint64_t>(1) << 63;
+	unsigned char    letters[256] = {0};
+	unsigned int     nbLetters    = 1;
+	for (char c: firstString) {
+		unsigned char &letter = letters[static_cast<unsigned char>(c)];
+		if (letter == 0) {
+			letter = nbLetters++;
+		}
+	}
+	vector <uint64_t> peq(nbLetters * nbWords, 0);
+	vector <uint64_t> pv(nbWords, static_cast<uint64_t>(-1)), mv(nbWords, 0);
+	for (unsigned int j = 0; j < firstSize; j++) {
+		peq[letters[static_cast<unsigned char>(firstString[j])] * nbWords + j / 64] |= static_cast<uint64_t>(1) << (j % 64);
+	}
+	int score = firstSize;
+	for (unsigned int i = 0; i < secondSize; i++) {
+		const uint64_t *eqs = &peq[letters[static_cast<unsigned char>(secondString[i])] * nbWords];
+		int             hin = 0;
+		for (unsigned int word = 0; word < nbWords; word++) {
+			uint64_t eq = eqs[word], p = pv[word], m = mv[word];
+			uint64_t xv = eq | m;
+			if (hin < 0) {
+				eq |= 1;
 			}
-			catch (...) {
-				return false;
+			uint64_t xh   = (((eq & p) + p) ^ p) | eq;
+			uint64_t ph   = m | ~(xh | p);
+			uint64_t mh   = p & xh;
+			uint64_t high = (word == nbWords - 1)? lastBit: highBit;
+			int      hout = (ph & high)? 1: ((mh & high)? -1: 0);
+			ph <<= 1;
+			mh <<= 1;
+			if (hin < 0) {
+				mh |= 1;
 			}
-			current = tmp;
-			//cout << table[i][j] << " ";
+			else if (hin > 0) {
+				ph |= 1;
+			}
+			pv[word] = mh | ~(xv | ph);
+			mv[word] = ph & xv;
+			hin      = hout;
 		}
-		if (line[firstSize] < maxPenalty) {
-			//cout << "\t\tfound good hit at (" << i << ", " << secondString.size() << ") with penalty " << table[i][secondString.size()] << endl;
-			//cout << "Leaving it 1" << endl;
+		score += hin;
+		if (score < maxPenalty) {
 			return true;
 		}
-		//cout << endl;
+		if (score - static_cast<int>(secondSize - i - 1) >= maxPenalty) {
+			return false;
+		}
 	}
-	//cout << "Leaving it 2" << endl;
 	return false;
 }
 
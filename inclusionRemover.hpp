@@ -20,7 +20,7 @@ along with this program.
 #include <iostream>
 #include "globals.hpp"
 #include "repeats.hpp"
-#include "kmerSet.hpp"
+#include "seedIndex.hpp"
 using namespace std;
 
 
@@ -28,8 +28,8 @@ using namespace std;
 class InclusionRemover {
 
     private:
-		vector <KmerSet> _kmerSets;
-		Repeats  _repeats;
+		SeedIndex _seedIndex;
+		Repeats   _repeats;
 
     public:
         InclusionRemover (const Repeats &repeats);
@@ -37,8 +37,8 @@ class InclusionRemover {
 		const Repeats &getRepeats();
 
 	private:
-		void storeKmers ();
-		bool checkInclusion (const unsigned int i, const unsigned int j) const;
+		unsigned int getMinShared (const unsigned int i) const;
+		bool checkInclusion (const string &firstString, const unsigned int j) const;
 		bool compareStrings (const string &firstString, const string &secondString) const;
 
 		friend ostream& operator<<(ostream& output, const InclusionRemover& ir);
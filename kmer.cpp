@@ -70,12 +70,12 @@ const Sequence &Kmer::getSequence() const {
 	return _sequence;
 }
 
-const string &Kmer::getFirstWord() const {
+string Kmer::getFirstWord() const {
     return _sequence.getFirstWord();
 }
 
 
-const string &Kmer::getSecondWord() const {
+string Kmer::getSecondWord() const {
     return _sequence.getSecondWord();
 }
 
@@ -86,8 +86,8 @@ void Kmer::computeFirstCode() {
     for (int i = 0; i < size; i++) {
 		_firstCode  <<= Globals::NB_BITS_NUCLEOTIDES;
 		_secondCode <<= Globals::NB_BITS_NUCLEOTIDES;
-		_firstCode  |= Globals::getCode(_sequence.getFirstWord()[i]);
-		_secondCode |= Globals::getCode(Globals::getComplement(_sequence.getFirstWord()[size - i - 1]));
+		_firstCode  |= Globals::getCode(_sequence.getNucleotide(i));
+		_secondCode |= Globals::getCode(Globals::getComplement(_sequence.getNucleotide(size - i - 1)));
 	}
 	if (_secondCode < _firstCode) {
 		swap(_firstCode, _secondCode);
@@ -120,6 +120,7 @@ void Kmer::computeWords() {
 const KmerCode Kmer::getCodeAfter(const int code) const {
 	KmerCode newCode(code);
 	newCode |= _firstCode << Globals::NB_BITS_NUCLEOTIDES;
+	newCode &= UNSET >> (Globals::NB_BLOCKS * block_s - Globals::NB_BITS_NUCLEOTIDES * Globals::KMER);
 	Kmer kmer(newCode);
 	return kmer.getFirstCode();
 }
@@ -41,8 +41,8 @@ class Kmer {
         const KmerCode getFirstCode  () const;
         const KmerCode getSecondCode () const;
 		const Sequence &getSequence () const;
-		const string &getFirstWord () const;
-		const string &getSecondWord () const;
+		string getFirstWord () const;
+		string getSecondWord () const;
 		const KmerCode getCodeAfter (int code) const;
 		const KmerCode getCodeBefore (int code) const;
 		const KmerCode getCodeNeighbor (const short code, const short direction) const;
@@ -55,6 +55,18 @@ class KmerCode {
 			return murmurHash(_code, sizeof(block_t) * Globals::NB_BLOCKS, 0);
 		}
 
+		uint32_t hash(const uint32_t seed) const {
+			return murmurHash(_code, sizeof(block_t) * Globals::NB_BLOCKS, seed);
+		}
+
+		block_t getBlock(const int i) const {
+			return _code[i];
+		}
+
+		void setBlock(const int i, const block_t block) {
+			_code[i] = block;
+		}
+
 		friend bool operator== (const KmerCode &c1, const KmerCode &c2);
 		friend bool operator!= (const KmerCode &c1, const KmerCode &c2);
 		friend bool operator< (const KmerCode &c1, const KmerCode &c2);
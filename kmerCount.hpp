@@ -0,0 +1,58 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef KMER_COUNT_HPP
+#define KMER_COUNT_HPP 1
+
+#include "globals.hpp"
+#include "kmer.hpp"
+#include "bloomFilter.hpp"
+using namespace std;
+
+// Interface of the k-mer tables which are used by the graph phase.
+// Once the table is fixed, a Bloom filter can be built, so that most absent
+// k-mers are discarded without accessing the table.
+// The edges of each k-mer can also be computed once: the bit
+// (position * NB_NUCLEOTIDES + nucleotide) of the edge mask is set iff
+// getCodeNeighbor(nucleotide, position) is in the table.
+class KmerCount {
+
+    protected:
+		BloomFilter _filter;
+
+    public:
+		virtual ~KmerCount () {}
+		virtual KmerNb getCount (const Kmer &kmer) const = 0;
+		virtual KmerNb getCount (const KmerCode &code) const = 0;
+		virtual void remove (const KmerCode &kmerCode) = 0;
+		virtual pair <KmerCode, KmerNb> getRandom () = 0;
+		virtual bool empty () const = 0;
+		virtual unsigned int getSize () const = 0;
+		virtual void buildFilter () = 0;
+		virtual void buildEdges () = 0;
+		virtual unsigned char getEdges (const KmerCode &code) const = 0;
+
+		// Look up several k-mers at once, so that an implementation can overlap the memory accesses.
+		virtual void getCounts (const KmerCode *codes, const unsigned int n, KmerNb *counts, unsigned char *edges = nullptr) const {
+			for (unsigned int i = 0; i < n; i++) {
+				counts[i] = getCount(codes[i]);
+				if (edges != nullptr) {
+					edges[i] = getEdges(codes[i]);
+				}
+			}
+		}
+};
+
+#endif
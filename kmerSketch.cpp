@@ -0,0 +1,77 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <algorithm>
+#include "kmerSketch.hpp"
+
+KmerSketch::KmerSketch() {}
+
+// The codes are computed with rolling codes, on both strands.  The k-mers
+// with an ambiguous nucleotide are skipped.
+void KmerSketch::setSequence(const string &sequence) {
+	unsigned int size    = Globals::SHORT_KMER_SIZE;
+	uint64_t     mask    = (size * Globals::NB_BITS_NUCLEOTIDES >= 64)? static_cast<uint64_t>(-1): (static_cast<uint64_t>(1) << (size * Globals::NB_BITS_NUCLEOTIDES)) - 1;
+	unsigned int shift   = (size - 1) * Globals::NB_BITS_NUCLEOTIDES;
+	uint64_t     maxHash = static_cast<uint64_t>(-1) / max<unsigned int>(Globals::SKETCH_SCALE, 1);
+	uint64_t     forward = 0, reverse = 0;
+	unsigned int length  = 0;
+	_hashes.clear();
+	for (char c: sequence) {
+		int code = Globals::getCode(c);
+		if (code == Globals::NB_NUCLEOTIDES) {
+			length = 0;
+			continue;
+		}
+		forward = ((forward << Globals::NB_BITS_NUCLEOTIDES) | code) & mask;
+		reverse = (reverse >> Globals::NB_BITS_NUCLEOTIDES) | (static_cast<uint64_t>(Globals::getComplementCode(code)) << shift);
+		if (++length >= size) {
+			uint64_t value = hash(min<uint64_t>(forward, reverse));
+			if (value <= maxHash) {
+				_hashes.push_back(value);
+			}
+		}
+	}
+	sort(_hashes.begin(), _hashes.end());
+	_hashes.erase(unique(_hashes.begin(), _hashes.end()), _hashes.end());
+	_hashes.shrink_to_fit();
+}
+
+unsigned int KmerSketch::getSize() const {
+	return _hashes.size();
+}
+
+const vector <uint64_t> &KmerSketch::getHashes() const {
+	return _hashes;
+}
+
+// Bijective mixing function (splitmix64 finalizer), so that no two k-mers
+// get the same hash.
+uint64_t KmerSketch::hash(uint64_t code) {
+	code = (code ^ (code >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	code = (code ^ (code >> 27)) * 0x94d049bb133111ebULL;
+	return code ^ (code >> 31);
+}
+
+ostream& operator<<(ostream& output, const KmerSketch &ks) {
+	for (uint64_t hash: ks._hashes) {
+		output << hash << "\t";
+	}
+	output << endl;
+	return output;
+}
@@ -13,29 +13,35 @@ See the GNU Affero General Public License for more details.
 You should have received a copy of the GNU Affero General Public License
 along with this program.
 **/
-#ifndef KMERSET_HPP
-#define KMERSET_HPP 1
+#ifndef KMER_SKETCH_HPP
+#define KMER_SKETCH_HPP 1
 
+#include <cstdint>
 #include <string>
-#include <set>
+#include <vector>
 #include <iostream>
+#include "globals.hpp"
 using namespace std;
 
-typedef unsigned int s_kmer_t;
-typedef set < s_kmer_t > s_kmers_t;
-
-class KmerSet {
+// Sketch of the short k-mers of a sequence (FracMinHash): the canonical
+// k-mers are hashed, and only the hashes below 2^64 / SKETCH_SCALE are kept,
+// sorted.  With a scale of 1, every k-mer is kept, and the number of shared
+// hashes is the number of shared k-mers.
+class KmerSketch {
 
     private:
-		s_kmers_t _kmers;
+		vector <uint64_t> _hashes;
 
     public:
-        KmerSet ();
+        KmerSketch ();
 
 		void setSequence (const string &sequence);
-		const bool compare (const KmerSet &ks) const;
+		unsigned int getSize () const;
+		const vector <uint64_t> &getHashes () const;
+
+		static uint64_t hash (uint64_t code);
 
-		friend ostream& operator<<(ostream& output, const KmerSet& ks);
+		friend ostream& operator<<(ostream& output, const KmerSketch& ks);
 };
 
 #endif
@@ -19,11 +19,12 @@ along with this program.
 
 #include <algorithm>
 #include <thread>
+#include <mutex>
 #include "loopOpener.hpp"
 #include "kmerIterator.hpp"
 #include "fastxParser.hpp"
 
-LoopOpener::LoopOpener(const char *fileName, const Repeats &repeats): _fileName(fileName), _repeats(repeats), _nbLoops(0) { }
+LoopOpener::LoopOpener(const char *fileName, const Repeats &repeats, const FrozenKmerCount *kmerCount): _fileName(fileName), _kmerCount(kmerCount), _repeats(repeats), _nbLoops(0) { }
 
 void LoopOpener::openLoops() {
 	for (unsigned int i = 0; i < _repeats.getNbRepeats(); i++) {
@@ -35,7 +36,12 @@ void LoopOpener::openLoops() {
 	if (empty()) {
 		return;
 	}
-	readReads();
+	if (_kmerCount != nullptr) {
+		readIndex();
+	}
+	else {
+		readReads();
+	}
 	for (unsigned int i = 0; i < _repeats.getNbRepeats(); i++) {
 		if (_repeats[i].isLoop()) {
 			string sequence        = _repeats[i].getRepeat().getFirstWord();
@@ -69,14 +75,18 @@ void LoopOpener::addLoop(const Sequence &loop) {
 	}
 }
 
+// Each thread counts the loop k-mers of its reads in its own array, with
+// rolling codes, and the arrays are summed at the end.
 void LoopOpener::readReads() {
 	cout << "Starting loop opener, " << _nbLoops << " loop(s) found..." << endl;
-	vector <thread> threads(Globals::NB_THREADS);
-	mutex m1, m2, m3;
+	buildTable();
+	vector <thread>          threads(Globals::NB_THREADS);
+	vector <vector <KmerNb> > threadCounts(Globals::NB_THREADS, vector <KmerNb> (_codes.size(), 0));
+	mutex m1;
 	int   partId = 0;
 	unsigned long nbReads = 0;
 	for (int threadId = 0; threadId < Globals::NB_THREADS; threadId++) {
-		threads[threadId] = thread([this, &partId, &nbReads, &m1, &m2, &m3]() {
+		threads[threadId] = thread([this, threadId, &threadCounts, &partId, &nbReads, &m1]() {
 			FastxParser *parser;
 			if (Globals::FASTA_INPUT) {
 				parser = new FastaParser(_fileName);
@@ -84,32 +94,28 @@ void LoopOpener::readReads() {
 			else {
 				parser = new FastqParser(_fileName);
 			}
-			Kmer currentKmer;
-			KmerCode currentCode;
+			// the number of reads, as seen the last time the lock was held
+			unsigned long thisNbReads = 0;
 			while (! parser->isAllRead()) {
 				long unsigned thisPartId;
-				if (nbReads > 0) {
-					cout << "\t" << nbReads << " reads read." << endl;
+				if (thisNbReads > 0) {
+					cout << "\t" << thisNbReads << " reads read." << endl;
 				}
-				if ((Globals::NB_READS != 0) && (nbReads > Globals::NB_READS)) {
-					cout << "\t" << nbReads << " reads read." << endl;
-					return;
+				if ((Globals::NB_READS != 0) && (thisNbReads > Globals::NB_READS)) {
+					cout << "\t" << thisNbReads << " reads read." << endl;
+					break;
 				}
 				{
 					lock_guard<mutex> lock(m1);
-					thisPartId = partId;
-					nbReads   += parser->getReadId();
+					thisPartId  = partId;
+					nbReads    += parser->getReadId();
+					thisNbReads = nbReads;
 					++partId;
 				}
 				parser->goTo(thisPartId * Globals::SIZE_THREAD, (thisPartId != 0));
 				parser->endTo((thisPartId+1) * Globals::SIZE_THREAD - 1);
-				for (unsigned long i = 0; !parser->isOver(); i++, parser->getNextKmer()) {
-					currentKmer = Kmer(parser->getSequence());
-					currentCode = currentKmer.getFirstCode();
-					if (_count.find(currentCode) != _count.end()) {
-						lock_guard<mutex> lock(m2);
-						_count[currentCode]++;
-					}
+				for (parser->getNextLine(); ! parser->isOver(); parser->getNextLine()) {
+					countLine(parser->getLine(), threadCounts[threadId]);
 				}
 			}
 			delete parser;
@@ -118,8 +124,74 @@ void LoopOpener::readReads() {
 	for (int threadId = 0; threadId < Globals::NB_THREADS; threadId++) {
 		threads[threadId].join();
 	}
+	for (const vector <KmerNb> &counts: threadCounts) {
+		for (unsigned int i = 0; i < _codes.size(); i++) {
+			if (counts[i] > 0) {
+				_count[_codes[i]] += counts[i];
+			}
+		}
+	}
+}
+
+void LoopOpener::buildTable() {
+	unsigned int size = 2;
+	while (size < 2 * _count.size()) {
+		size *= 2;
+	}
+	_codes.assign(size, Kmer::UNSET);
+	_mask = size - 1;
+	for (auto &count: _count) {
+		unsigned int i = count.first.hash() & _mask;
+		while (_codes[i] != Kmer::UNSET) {
+			i = (i + 1) & _mask;
+		}
+		_codes[i] = count.first;
+	}
+}
+
+unsigned int LoopOpener::lookup(const KmerCode &code) const {
+	for (unsigned int i = code.hash() & _mask; _codes[i] != Kmer::UNSET; i = (i + 1) & _mask) {
+		if (_codes[i] == code) {
+			return i;
+		}
+	}
+	return _codes.size();
 }
 
+// The k-mers are the ones given by the parser: the ambiguous and the low
+// complexity k-mers are skipped.
+void LoopOpener::countLine(const string &line, vector <KmerNb> &counts) const {
+	KmerCode     mask = Kmer::UNSET >> (Globals::NB_BLOCKS * block_s - Globals::NB_BITS_NUCLEOTIDES * Globals::KMER);
+	KmerCode     forward(0), reverse(0);
+	unsigned int shift = Globals::NB_BITS_NUCLEOTIDES * (Globals::KMER - 1);
+	unsigned int size  = 0;
+	for (unsigned int i = 0; i < line.size(); i++) {
+		int code = Globals::getCode(line[i]);
+		if (code == Globals::NB_NUCLEOTIDES) {
+			size = 0;
+			continue;
+		}
+		forward = ((forward << Globals::NB_BITS_NUCLEOTIDES) | KmerCode(code)) & mask;
+		reverse = (reverse >> Globals::NB_BITS_NUCLEOTIDES) | (KmerCode(Globals::getComplementCode(code)) << shift);
+		if (++size < Globals::KMER) {
+			continue;
+		}
+		unsigned int slot = lookup((reverse < forward)? reverse: forward);
+		if ((slot != _codes.size()) && (! Sequence::isLowComplexity(line.substr(i + 1 - Globals::KMER, Globals::KMER)))) {
+			counts[slot]++;
+		}
+	}
+}
+
+// The k-mers which have been used by the graphs are only flagged in the
+// index, so their counts are still there.
+void LoopOpener::readIndex() {
+	cout << "Starting loop opener, " << _nbLoops << " loop(s) found, using the k-mer index..." << endl;
+	for (auto &count: _count) {
+		unsigned int slot = _kmerCount->getSlot(count.first);
+		count.second = (slot == MinimalPerfectHash::NOT_FOUND)? 0: _kmerCount->getSlotCount(slot);
+	}
+}
 
 pair <int, int> LoopOpener::getOverRepresented(const string &loop) {
 	vector < pair <int, int> > regions, mergedRegions;
@@ -19,26 +19,33 @@ along with this program.
 #include <iostream>
 #include <vector>
 #include <map>
-#include <mutex>
 #include "globals.hpp"
 #include "kmerCode.hpp"
 #include "kmer.hpp"
 #include "sequence.hpp"
 #include "repeats.hpp"
+#include "frozenKmerCount.hpp"
 using namespace std;
 
 
+// When the frozen index is still available, the k-mers of the loops are
+// counted with it, instead of reading the reads again.
 class LoopOpener {
 
     private:
-		const char *_fileName;
-		Repeats     _repeats;
-		int         _nbLoops;
+		const char            *_fileName;
+		const FrozenKmerCount *_kmerCount;
+		Repeats                _repeats;
+		int                    _nbLoops;
 
 		map < KmerCode, KmerNb > _count;
 
+		// Read-only open addressing table of the loop k-mers, used while reading.
+		vector < KmerCode > _codes;
+		unsigned int        _mask;
+
     public:
-        LoopOpener (const char *fileName, const Repeats &repeats);
+        LoopOpener (const char *fileName, const Repeats &repeats, const FrozenKmerCount *kmerCount = nullptr);
 		void openLoops ();
 		const Repeats &getRepeats();
 
@@ -48,6 +55,10 @@ class LoopOpener {
 		void reset ();
 		void addLoop (const Sequence &loop);
 		void readReads ();
+		void readIndex ();
+		void buildTable ();
+		unsigned int lookup (const KmerCode &code) const;
+		void countLine (const string &line, vector <KmerNb> &counts) const;
 
 		pair <int, int> getOverRepresented (const string &loop);
 		int getWeakPosition (const string &loop);
@@ -0,0 +1,118 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include "minimalPerfectHash.hpp"
+
+constexpr float        MinimalPerfectHash::GAMMA;
+constexpr unsigned int MinimalPerfectHash::MAX_LEVELS;
+constexpr unsigned int MinimalPerfectHash::NOT_FOUND;
+
+MinimalPerfectHash::MinimalPerfectHash (): _size(0) { }
+
+void MinimalPerfectHash::build (const vector <KmerCode> &allKeys) {
+	clear();
+	_size = allKeys.size();
+	unsigned int             nbThreads = max<int>(Globals::NB_THREADS, 1);
+	unsigned int             offset    = 0;
+	vector <KmerCode>        remainingKeys;
+	const vector <KmerCode> *currentKeys = &allKeys;
+	for (unsigned int level = 0; (level < MAX_LEVELS) && (! currentKeys->empty()); level++) {
+		const vector <KmerCode> &keys = *currentKeys;
+		unsigned long nbWords = static_cast<unsigned long>(ceil(GAMMA * keys.size() / 64.0));
+		vector <atomic <uint64_t> > seen(nbWords), collisions(nbWords);
+		vector <vector <KmerCode> > remaining(nbThreads);
+		vector <thread> threads;
+		for (unsigned long i = 0; i < nbWords; i++) {
+			seen[i]       = 0;
+			collisions[i] = 0;
+		}
+		for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+			threads.emplace_back([&, threadId]() {
+				for (unsigned long i = threadId; i < keys.size(); i += nbThreads) {
+					unsigned long position = getPosition(keys[i], level, nbWords);
+					uint64_t      bit      = static_cast<uint64_t>(1) << (position % 64);
+					if (seen[position / 64].fetch_or(bit) & bit) {
+						collisions[position / 64].fetch_or(bit);
+					}
+				}
+			});
+		}
+		for (thread &t: threads) {
+			t.join();
+		}
+		threads.clear();
+		for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+			threads.emplace_back([&, threadId]() {
+				for (unsigned long i = threadId; i < keys.size(); i += nbThreads) {
+					unsigned long position = getPosition(keys[i], level, nbWords);
+					if (collisions[position / 64] & (static_cast<uint64_t>(1) << (position % 64))) {
+						remaining[threadId].push_back(keys[i]);
+					}
+				}
+			});
+		}
+		for (thread &t: threads) {
+			t.join();
+		}
+		_levels.push_back(vector <uint64_t> (nbWords));
+		_ranks.push_back(vector <unsigned int> (nbWords));
+		_offsets.push_back(offset);
+		vector <uint64_t>     &bits  = _levels.back();
+		vector <unsigned int> &ranks = _ranks.back();
+		unsigned int rank = 0;
+		for (unsigned long i = 0; i < nbWords; i++) {
+			bits[i]  = seen[i] & ~collisions[i];
+			ranks[i] = rank;
+			rank    += __builtin_popcountll(bits[i]);
+		}
+		offset += rank;
+		vector <KmerCode> nextKeys;
+		for (vector <KmerCode> &r: remaining) {
+			nextKeys.insert(nextKeys.end(), r.begin(), r.end());
+		}
+		remainingKeys.swap(nextKeys);
+		currentKeys = &remainingKeys;
+	}
+	for (const KmerCode &code: *currentKeys) {
+		_fallback[code] = offset++;
+	}
+}
+
+void MinimalPerfectHash::clear () {
+	_levels.clear();
+	_ranks.clear();
+	_offsets.clear();
+	_fallback.clear();
+	_size = 0;
+}
+
+unsigned int MinimalPerfectHash::getSize () const {
+	return _size;
+}
+
+unsigned long MinimalPerfectHash::getMemory () const {
+	unsigned long memory = 0;
+	for (unsigned int level = 0; level < _levels.size(); level++) {
+		memory += _levels[level].size() * (sizeof(uint64_t) + sizeof(unsigned int));
+	}
+	return memory + _fallback.size() * (sizeof(KmerCode) + sizeof(unsigned int));
+}
@@ -0,0 +1,82 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef MINIMAL_PERFECT_HASH_HPP
+#define MINIMAL_PERFECT_HASH_HPP 1
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "globals.hpp"
+#include "kmerCode.hpp"
+using namespace std;
+
+// Minimal perfect hash function on a fixed set of k-mer codes.
+// Keys are hashed into successive bit arrays, as in BBHash: keys which
+// do not collide are stored in a level, the others go to the next one.
+// The value of a key is its rank among the stored bits.
+// Codes which are not in the set may get any value, and should be checked.
+class MinimalPerfectHash {
+
+	private:
+		static constexpr float        GAMMA      = 2.0;
+		static constexpr unsigned int MAX_LEVELS = 25;
+
+		vector <vector <uint64_t> >      _levels;
+		vector <vector <unsigned int> >  _ranks;
+		vector <unsigned int>            _offsets;
+		unordered_map <KmerCode, unsigned int> _fallback;
+		unsigned int                     _size;
+
+	public:
+		static constexpr unsigned int NOT_FOUND = -1;
+
+		MinimalPerfectHash ();
+		void build (const vector <KmerCode> &keys);
+		void clear ();
+		unsigned int getSize () const;
+		unsigned long getMemory () const;
+
+		unsigned int lookup (const KmerCode &code) const {
+			for (unsigned int level = 0; level < _levels.size(); level++) {
+				const vector <uint64_t> &bits = _levels[level];
+				unsigned long position = getPosition(code, level, bits.size());
+				uint64_t      word     = bits[position / 64];
+				uint64_t      bit      = static_cast<uint64_t>(1) << (position % 64);
+				if (word & bit) {
+					return _offsets[level] + _ranks[level][position / 64] + __builtin_popcountll(word & (bit - 1));
+				}
+			}
+			if (_fallback.empty()) {
+				return NOT_FOUND;
+			}
+			auto it = _fallback.find(code);
+			return (it == _fallback.end())? NOT_FOUND: it->second;
+		}
+
+		const uint64_t *getFirstAddress (const KmerCode &code) const {
+			if (_levels.empty()) {
+				return nullptr;
+			}
+			return &_levels[0][getPosition(code, 0, _levels[0].size()) / 64];
+		}
+
+	private:
+		static unsigned long getPosition (const KmerCode &code, const unsigned int level, const unsigned long nbWords) {
+			return (static_cast<uint64_t>(code.hash(level + 1)) * (nbWords * 64)) >> 32;
+		}
+};
+
+#endif
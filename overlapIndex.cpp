@@ -0,0 +1,236 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <algorithm>
+#include <thread>
+#include "overlapIndex.hpp"
+#include "kmerSketch.hpp"
+
+constexpr unsigned int OverlapIndex::MAX_OCCURRENCES;
+
+OverlapIndex::OverlapIndex () { }
+
+// The minimizers of the ends are computed in parallel, and sorted by hash.
+// Then, each repeat i looks for the repeats j < i in the lists of its
+// minimizers, and the seeds of a same overlap are gathered in a candidate,
+// with the range of their diagonals.
+void OverlapIndex::build (const Repeats &repeats) {
+	unsigned int                   nbRepeats = repeats.getNbRepeats();
+	unsigned int                   nbThreads = max<int>(Globals::NB_THREADS, 1);
+	vector <int>                   sizes(nbRepeats, 0);
+	vector <vector <Occurrence> >  threadOccurrences(nbThreads);
+	vector <vector <Candidate> >   candidates(nbRepeats);
+	vector <thread>                threads;
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int i = threadId; i < nbRepeats; i += nbThreads) {
+				if (! repeats.isRemoved(i)) {
+					const Sequence &sequence = repeats[i].getRepeat();
+					sizes[i] = min<int>(sequence.getSize(), Globals::MAX_MERGE_SIZE);
+					addMinimizers(sequence.getWord(Globals::DIRECT, sequence.getSize() - sizes[i], sizes[i]), i, Globals::AFTER, threadOccurrences[threadId]);
+					addMinimizers(sequence.getWord(Globals::DIRECT, 0, sizes[i]), i, Globals::BEFORE, threadOccurrences[threadId]);
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	threads.clear();
+	vector <Occurrence> occurrences;
+	for (vector <Occurrence> &o: threadOccurrences) {
+		occurrences.insert(occurrences.end(), o.begin(), o.end());
+		o.clear();
+		o.shrink_to_fit();
+	}
+	sort(occurrences.begin(), occurrences.end());
+	// the minimizers found in too many ends would give a quadratic number of
+	// seeds: they are dropped
+	unsigned int nbKept = 0;
+	for (unsigned int start = 0; start < occurrences.size(); ) {
+		unsigned int end = start + 1;
+		while ((end < occurrences.size()) && (occurrences[end]._hash == occurrences[start]._hash)) {
+			end++;
+		}
+		if (end - start <= MAX_OCCURRENCES) {
+			for (unsigned int o = start; o < end; o++) {
+				occurrences[nbKept++] = occurrences[o];
+			}
+		}
+		start = end;
+	}
+	occurrences.resize(nbKept);
+	// the first occurrence of the same hash, and the occurrences of each repeat
+	vector <unsigned int> groupStarts(occurrences.size());
+	vector <unsigned int> repeatStarts(nbRepeats + 1, 0), repeatOccurrences(occurrences.size());
+	for (unsigned int o = 0; o < occurrences.size(); o++) {
+		groupStarts[o] = ((o == 0) || (occurrences[o]._hash != occurrences[o-1]._hash))? o: groupStarts[o-1];
+		repeatStarts[occurrences[o]._repeat+1]++;
+	}
+	for (unsigned int i = 0; i < nbRepeats; i++) {
+		repeatStarts[i+1] += repeatStarts[i];
+	}
+	vector <unsigned int> positions(repeatStarts.begin(), repeatStarts.end() - 1);
+	for (unsigned int o = 0; o < occurrences.size(); o++) {
+		repeatOccurrences[positions[occurrences[o]._repeat]++] = o;
+	}
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			vector <Candidate> seeds;
+			for (unsigned int i = threadId; i < nbRepeats; i += nbThreads) {
+				seeds.clear();
+				for (unsigned int r = repeatStarts[i]; r < repeatStarts[i+1]; r++) {
+					const Occurrence &o1 = occurrences[repeatOccurrences[r]];
+					for (unsigned int o = groupStarts[repeatOccurrences[r]]; occurrences[o]._repeat < i; o++) {
+						Candidate seed;
+						if (getCandidate(o1, occurrences[o], sizes[occurrences[o]._repeat], seed)) {
+							seeds.push_back(seed);
+						}
+					}
+				}
+				sort(seeds.begin(), seeds.end(), [](const Candidate &c1, const Candidate &c2) {
+					return (c1._other != c2._other)? (c1._other < c2._other): ((c1._direction != c2._direction)? (c1._direction < c2._direction): ((c1._position != c2._position)? (c1._position < c2._position): (c1._minDiagonal < c2._minDiagonal)));
+				});
+				for (const Candidate &seed: seeds) {
+					if ((candidates[i].empty()) || (candidates[i].back()._other != seed._other) || (candidates[i].back()._direction != seed._direction) || (candidates[i].back()._position != seed._position)) {
+						candidates[i].push_back(seed);
+					}
+					else {
+						candidates[i].back()._maxDiagonal = seed._maxDiagonal;
+					}
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	_starts.assign(1, 0);
+	_candidates.clear();
+	for (unsigned int i = 0; i < nbRepeats; i++) {
+		_candidates.insert(_candidates.end(), candidates[i].begin(), candidates[i].end());
+		_starts.push_back(_candidates.size());
+	}
+}
+
+// The minimizers of each window of consecutive k-mers are added once.  The
+// k-mers with an ambiguous nucleotide, and the low complexity ones (e.g. in
+// a poly-A tail), are skipped.
+void OverlapIndex::addMinimizers (const string &end, const unsigned int repeat, const short position, vector <Occurrence> &occurrences) {
+	int          size    = Globals::SHORT_KMER_SIZE;
+	int          window  = max<int>(1, Globals::MIN_MERGE_SIZE - size + 1);
+	uint64_t     mask    = (size * Globals::NB_BITS_NUCLEOTIDES >= 64)? static_cast<uint64_t>(-1): (static_cast<uint64_t>(1) << (size * Globals::NB_BITS_NUCLEOTIDES)) - 1;
+	unsigned int shift   = (size - 1) * Globals::NB_BITS_NUCLEOTIDES;
+	uint64_t     forward = 0, reverse = 0;
+	int          length  = 0;
+	int          nbKmers = static_cast<int>(end.size()) - size + 1;
+	if (nbKmers <= 0) {
+		return;
+	}
+	vector <uint64_t> hashes(nbKmers);
+	vector <char>     forwards(nbKmers), valids(nbKmers, false);
+	for (int i = 0; i < static_cast<int>(end.size()); i++) {
+		int code = Globals::getCode(end[i]);
+		if (code == Globals::NB_NUCLEOTIDES) {
+			length = 0;
+			continue;
+		}
+		forward = ((forward << Globals::NB_BITS_NUCLEOTIDES) | code) & mask;
+		reverse = (reverse >> Globals::NB_BITS_NUCLEOTIDES) | (static_cast<uint64_t>(Globals::getComplementCode(code)) << shift);
+		if ((++length >= size) && (! Sequence::isLowComplexity(end.substr(i - size + 1, size)))) {
+			hashes[i - size + 1]   = KmerSketch::hash(min<uint64_t>(forward, reverse));
+			forwards[i - size + 1] = (forward <= reverse);
+			valids[i - size + 1]   = true;
+		}
+	}
+	int last = -1;
+	for (int start = 0; start <= max<int>(0, nbKmers - window); start++) {
+		int best = -1;
+		for (int i = start; i < min<int>(start + window, nbKmers); i++) {
+			if ((valids[i]) && ((best == -1) || (hashes[i] < hashes[best]))) {
+				best = i;
+			}
+		}
+		if ((best != -1) && (best != last)) {
+			Occurrence occurrence;
+			occurrence._hash     = hashes[best];
+			occurrence._repeat   = repeat;
+			occurrence._position = position;
+			occurrence._forward  = forwards[best];
+			occurrence._offset   = best;
+			occurrences.push_back(occurrence);
+			last = best;
+		}
+	}
+}
+
+// The seed shared by the end of the repeat i (first occurrence) and the
+// end of the repeat j < i (second occurrence, whose ends have size2
+// nucleotides).  The merger aligns the end of i with the start of j (AFTER),
+// or the end of j with the start of i (BEFORE), j being reversed in the
+// REVERSE direction: an end of j is then read on the other strand.  The
+// diagonal is the offset of the seed in the end, minus the one in the
+// start.
+bool OverlapIndex::getCandidate (const Occurrence &o1, const Occurrence &o2, const int size2, Candidate &candidate) {
+	bool sameStrand   = (o1._forward == o2._forward);
+	int  reverse2     = size2 - o2._offset - Globals::SHORT_KMER_SIZE;
+	candidate._other  = o2._repeat;
+	if ((o1._position == Globals::AFTER) && (o2._position == Globals::BEFORE) && (sameStrand)) {
+		candidate._direction   = Globals::DIRECT;
+		candidate._position    = Globals::AFTER;
+		candidate._minDiagonal = o1._offset - o2._offset;
+	}
+	else if ((o1._position == Globals::AFTER) && (o2._position == Globals::AFTER) && (! sameStrand)) {
+		candidate._direction   = Globals::REVERSE;
+		candidate._position    = Globals::AFTER;
+		candidate._minDiagonal = o1._offset - reverse2;
+	}
+	else if ((o1._position == Globals::BEFORE) && (o2._position == Globals::AFTER) && (sameStrand)) {
+		candidate._direction   = Globals::DIRECT;
+		candidate._position    = Globals::BEFORE;
+		candidate._minDiagonal = o2._offset - o1._offset;
+	}
+	else if ((o1._position == Globals::BEFORE) && (o2._position == Globals::BEFORE) && (! sameStrand)) {
+		candidate._direction   = Globals::REVERSE;
+		candidate._position    = Globals::BEFORE;
+		candidate._minDiagonal = reverse2 - o1._offset;
+	}
+	else {
+		return false;
+	}
+	candidate._maxDiagonal = candidate._minDiagonal;
+	return true;
+}
+
+unsigned int OverlapIndex::getNbCandidates () const {
+	return _candidates.size();
+}
+
+unsigned int OverlapIndex::getNbCandidates (const unsigned int i) const {
+	return _starts[i+1] - _starts[i];
+}
+
+const OverlapIndex::Candidate &OverlapIndex::getCandidate (const unsigned int i, const unsigned int c) const {
+	return _candidates[_starts[i] + c];
+}
+
+void OverlapIndex::clear () {
+	_starts.clear();
+	_candidates.clear();
+}
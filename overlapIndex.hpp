@@ -0,0 +1,78 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef OVERLAP_INDEX_HPP
+#define OVERLAP_INDEX_HPP 1
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "globals.hpp"
+#include "repeats.hpp"
+using namespace std;
+
+// Index of the ends of the repeats, which gives the pairs of repeats that
+// may overlap.  Only the first and the last MAX_MERGE_SIZE nucleotides of
+// the repeats (the parts which are aligned by the merger) are indexed, with
+// their minimizers: the canonical short k-mers with the smallest hash among
+// each window of consecutive k-mers.  The windows are short enough, so that
+// an exact overlap of MIN_MERGE_SIZE nucleotides always shares a minimizer.
+// Each shared minimizer gives a candidate overlap of the repeats i > j, with
+// a direction and a position (as in the merger), and the diagonal of the
+// seed in the alignment of the two ends.  The low complexity k-mers, and the
+// minimizers of more than MAX_OCCURRENCES ends, are not used.  The
+// candidates of the repeat i are _candidates[_starts[i].._starts[i+1]).
+class OverlapIndex {
+
+	public:
+		struct Candidate {
+			unsigned int _other;
+			short        _direction;
+			short        _position;
+			int          _minDiagonal, _maxDiagonal;
+		};
+
+	private:
+		static constexpr unsigned int MAX_OCCURRENCES = 100;
+
+		struct Occurrence {
+			uint64_t     _hash;
+			unsigned int _repeat;
+			short        _position;
+			bool         _forward;
+			int          _offset;
+
+			bool operator< (const Occurrence &o) const {
+				return (_hash != o._hash)? (_hash < o._hash): (_repeat < o._repeat);
+			}
+		};
+
+		vector <unsigned int> _starts;
+		vector <Candidate>    _candidates;
+
+	public:
+		OverlapIndex ();
+		void build (const Repeats &repeats);
+		unsigned int getNbCandidates () const;
+		unsigned int getNbCandidates (const unsigned int i) const;
+		const Candidate &getCandidate (const unsigned int i, const unsigned int c) const;
+		void clear ();
+
+	private:
+		static void addMinimizers (const string &end, const unsigned int repeat, const short position, vector <Occurrence> &occurrences);
+		static bool getCandidate (const Occurrence &o1, const Occurrence &o2, const int size2, Candidate &candidate);
+};
+
+#endif
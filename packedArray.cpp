@@ -0,0 +1,47 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "packedArray.hpp"
+
+PackedArray::PackedArray (): _width(0), _mask(0), _size(0) { }
+
+void PackedArray::resize (const unsigned long size, const unsigned int width) {
+	_size  = size;
+	_width = width;
+	_mask  = (width >= 64)? static_cast<uint64_t>(-1): ((static_cast<uint64_t>(1) << width) - 1);
+	_words.assign(size * width / 64 + 2, 0);
+}
+
+void PackedArray::clear () {
+	_words.clear();
+	_words.shrink_to_fit();
+	_size = 0;
+}
+
+unsigned long PackedArray::getSize () const {
+	return _size;
+}
+
+unsigned int PackedArray::getWidth () const {
+	return _width;
+}
+
+unsigned long PackedArray::getMemory () const {
+	return _words.size() * sizeof(uint64_t);
+}
@@ -0,0 +1,66 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef PACKED_ARRAY_HPP
+#define PACKED_ARRAY_HPP 1
+
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// Array of unsigned integers, each stored with a fixed number of bits (at most 64).
+class PackedArray {
+
+	private:
+		vector <uint64_t> _words;
+		unsigned int      _width;
+		uint64_t          _mask;
+		unsigned long     _size;
+
+	public:
+		PackedArray ();
+		void resize (const unsigned long size, const unsigned int width);
+		void clear ();
+		unsigned long getSize () const;
+		unsigned int getWidth () const;
+		unsigned long getMemory () const;
+
+		uint64_t get (const unsigned long i) const {
+			unsigned long bit    = i * _width;
+			unsigned long word   = bit / 64;
+			unsigned int  offset = bit % 64;
+			uint64_t      value  = _words[word] >> offset;
+			if (offset + _width > 64) {
+				value |= _words[word+1] << (64 - offset);
+			}
+			return value & _mask;
+		}
+
+		void set (const unsigned long i, const uint64_t value) {
+			unsigned long bit    = i * _width;
+			unsigned long word   = bit / 64;
+			unsigned int  offset = bit % 64;
+			_words[word] = (_words[word] & ~(_mask << offset)) | ((value & _mask) << offset);
+			if (offset + _width > 64) {
+				_words[word+1] = (_words[word+1] & ~(_mask >> (64 - offset))) | ((value & _mask) >> (64 - offset));
+			}
+		}
+
+		const uint64_t *getAddress (const unsigned long i) const {
+			return &_words[i * _width / 64];
+		}
+};
+
+#endif
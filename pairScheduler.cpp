@@ -0,0 +1,73 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <thread>
+#include <mutex>
+#include "pairScheduler.hpp"
+
+PairScheduler::PairScheduler (const unsigned int size, const unsigned int nbThreads): _size(size), _nbThreads(max<unsigned int>(nbThreads, 1)), _removed((size + 63) / 64) {
+	for (atomic <uint64_t> &word: _removed) {
+		word = 0;
+	}
+}
+
+bool PairScheduler::isRemoved (const unsigned int i) const {
+	return (_removed[i / 64].load(memory_order_relaxed) >> (i % 64)) & 1;
+}
+
+void PairScheduler::remove (const unsigned int i) {
+	_removed[i / 64].fetch_or(static_cast<uint64_t>(1) << (i % 64), memory_order_relaxed);
+}
+
+// Call process(threadId, i, removals) for each non-removed element i; the
+// process adds the elements that row i removes to removals.  A finished row
+// is committed once all the previous rows are: its removals are then
+// applied, unless a previous row has removed i.  The bitmap only holds
+// the committed removals, so the removed elements are the ones of a
+// sequential run.
+void PairScheduler::runRows (const function <void (unsigned int, unsigned int, vector <unsigned int> &)> &process) {
+	atomic <unsigned int>           next(0);
+	unsigned int                    nbCommitted = 0;
+	vector <bool>                   done(_size, false);
+	vector <vector <unsigned int> > removals(_size);
+	mutex                           commitMutex;
+	vector <thread>                 threads;
+	for (unsigned int threadId = 0; threadId < _nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int i = next++; i < _size; i = next++) {
+				if (! isRemoved(i)) {
+					process(threadId, i, removals[i]);
+				}
+				lock_guard <mutex> lock(commitMutex);
+				done[i] = true;
+				for (; (nbCommitted < _size) && (done[nbCommitted]); nbCommitted++) {
+					if (! isRemoved(nbCommitted)) {
+						for (unsigned int j: removals[nbCommitted]) {
+							remove(j);
+						}
+					}
+					vector <unsigned int>().swap(removals[nbCommitted]);
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+}
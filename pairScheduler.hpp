@@ -0,0 +1,48 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef PAIR_SCHEDULER_HPP
+#define PAIR_SCHEDULER_HPP 1
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include "globals.hpp"
+using namespace std;
+
+// Distributes the rows of the comparisons of a set of elements to the
+// threads.  The rows are given one by one, in increasing order, from a
+// shared cursor.  A row may remove some of the next elements: the removals
+// of the rows are applied in the order of the rows, so that the result
+// does not depend on the number of threads.  The removed elements are
+// published in an atomic bitmap, and their rows are skipped.
+class PairScheduler {
+
+	private:
+		unsigned int                    _size;
+		unsigned int                    _nbThreads;
+		vector <atomic <uint64_t> >     _removed;
+
+	public:
+		PairScheduler (const unsigned int size, const unsigned int nbThreads);
+
+		bool isRemoved (const unsigned int i) const;
+		void remove (const unsigned int i);
+
+		void runRows (const function <void (unsigned int, unsigned int, vector <unsigned int> &)> &process);
+};
+
+#endif
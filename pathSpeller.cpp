@@ -0,0 +1,135 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <algorithm>
+#include "pathSpeller.hpp"
+
+
+PathSpeller::PathSpeller (): _size(0) {}
+
+// Like string::substr, the segment is cut to the size of the sequence.
+PathSpeller::Segment PathSpeller::getSegment (const Sequence *sequence, short direction, unsigned int start, unsigned int length) const {
+	Segment segment;
+	segment._sequence  = sequence;
+	segment._direction = direction;
+	segment._start     = (sequence == nullptr)? 0: min<unsigned int>(start, sequence->getSize());
+	segment._length    = (sequence == nullptr)? length: min<unsigned int>(length, sequence->getSize() - segment._start);
+	return segment;
+}
+
+char PathSpeller::getChar (const Segment &segment, unsigned int i) const {
+	if (segment._sequence == nullptr) {
+		return 'N';
+	}
+	return segment._sequence->getNucleotide(segment._start + i, segment._direction);
+}
+
+void PathSpeller::append (const Sequence &sequence, short direction, unsigned int start, unsigned int length) {
+	Segment segment = getSegment(&sequence, direction, start, length);
+	if (segment._length > 0) {
+		_segments.push_back(segment);
+		_size += segment._length;
+	}
+}
+
+void PathSpeller::prepend (const Sequence &sequence, short direction, unsigned int start, unsigned int length) {
+	Segment segment = getSegment(&sequence, direction, start, length);
+	if (segment._length > 0) {
+		_segments.push_front(segment);
+		_size += segment._length;
+	}
+}
+
+void PathSpeller::appendGap (unsigned int length) {
+	if (length > 0) {
+		_segments.push_back(getSegment(nullptr, Globals::DIRECT, 0, length));
+		_size += length;
+	}
+}
+
+void PathSpeller::prependGap (unsigned int length) {
+	if (length > 0) {
+		_segments.push_front(getSegment(nullptr, Globals::DIRECT, 0, length));
+		_size += length;
+	}
+}
+
+void PathSpeller::trimFront (unsigned int length) {
+	while ((length > 0) && (! _segments.empty())) {
+		Segment &segment = _segments.front();
+		if (segment._length <= length) {
+			length -= segment._length;
+			_size  -= segment._length;
+			_segments.pop_front();
+		}
+		else {
+			segment._start  += length;
+			segment._length -= length;
+			_size           -= length;
+			length           = 0;
+		}
+	}
+}
+
+void PathSpeller::clear () {
+	_segments.clear();
+	_size = 0;
+}
+
+unsigned int PathSpeller::getSize () const {
+	return _size;
+}
+
+string PathSpeller::getPrefix (unsigned int length) const {
+	string prefix;
+	length = min<unsigned int>(length, _size);
+	prefix.reserve(length);
+	for (auto it = _segments.begin(); prefix.size() < length; ++it) {
+		for (unsigned int i = 0; (i < it->_length) && (prefix.size() < length); i++) {
+			prefix.push_back(getChar(*it, i));
+		}
+	}
+	return prefix;
+}
+
+string PathSpeller::getSuffix (unsigned int length) const {
+	length = min<unsigned int>(length, _size);
+	string       suffix(length, 'N');
+	unsigned int end = length;
+	for (auto it = _segments.rbegin(); end > 0; ++it) {
+		for (unsigned int i = it->_length; (i > 0) && (end > 0); i--) {
+			suffix[--end] = getChar(*it, i-1);
+		}
+	}
+	return suffix;
+}
+
+string PathSpeller::getSequence () const {
+	string       sequence(_size, 'N');
+	unsigned int offset = 0;
+	for (const Segment &segment: _segments) {
+		if (segment._sequence != nullptr) {
+			for (unsigned int i = 0; i < segment._length; i++) {
+				sequence[offset + i] = getChar(segment, i);
+			}
+		}
+		offset += segment._length;
+	}
+	return sequence;
+}
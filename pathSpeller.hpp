@@ -0,0 +1,60 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef PATH_SPELLER_HPP
+#define PATH_SPELLER_HPP 1
+
+#include <deque>
+#include <string>
+#include "globals.hpp"
+#include "sequence.hpp"
+using namespace std;
+
+// Spells the sequence of a path.  The parts of the node sequences (or the
+// gaps) are added at both ends as segments, which refer to the sequences of
+// the nodes, and the whole sequence is written once, at the end.
+// The sequences should not change until the path is spelled.
+class PathSpeller {
+
+	private:
+		struct Segment {
+			const Sequence *_sequence;
+			short           _direction;
+			unsigned int    _start;
+			unsigned int    _length;
+		};
+
+		deque <Segment> _segments;
+		unsigned int    _size;
+
+		Segment getSegment (const Sequence *sequence, short direction, unsigned int start, unsigned int length) const;
+		char getChar (const Segment &segment, unsigned int i) const;
+
+	public:
+		PathSpeller ();
+		void append (const Sequence &sequence, short direction, unsigned int start = 0, unsigned int length = -1);
+		void prepend (const Sequence &sequence, short direction, unsigned int start = 0, unsigned int length = -1);
+		void appendGap (unsigned int length);
+		void prependGap (unsigned int length);
+		void trimFront (unsigned int length);
+		void clear ();
+
+		unsigned int getSize () const;
+		string getPrefix (unsigned int length) const;
+		string getSuffix (unsigned int length) const;
+		string getSequence () const;
+};
+
+#endif
@@ -17,15 +17,16 @@ along with this program.
 #include <config.h>
 #endif
 
-#include <set>
 #include <algorithm>
-#include <mutex>
+#include <atomic>
 #include <thread>
 #include "globals.hpp"
 #include "repeatMerger.hpp"
+#include "pairScheduler.hpp"
 #include "graphTrimmer.hpp"
+#include "pathSpeller.hpp"
 
-RepeatMerger::RepeatMerger(const Repeats &repeats, const KmerNb minCount): _size(repeats.getNbRepeats()), _minCount(minCount), _inputRepeats(repeats), _maxPenalty(numeric_limits<Penalty>::max()), _comparisons(_size)  {}
+RepeatMerger::RepeatMerger(const Repeats &repeats, const KmerNb minCount): _size(repeats.getNbRepeats()), _minCount(minCount), _inputRepeats(repeats), _maxPenalty(numeric_limits<Penalty>::max())  {}
 
 void RepeatMerger::addRepeat (const Sequence &repeat, const KmerNb count) {
 	_inputRepeats.addRepeat(repeat, count);
@@ -76,14 +77,11 @@ void RepeatMerger::mergeRepeats () {
 }
 
 void RepeatMerger::buildStructure () {
-	_kmerSets = new KmerSet[_size];
-	for (unsigned int i = 0; i < _size; i++) {
-		_kmerSets[i].setSequence(_inputRepeats[i].getRepeat().getFirstWord());
-	}
+	_comparisons.assign(_size, vector <Comparison> ());
 }
 
 void RepeatMerger::cleanStructure () {
-	delete[] _kmerSets;
+	_comparisons.clear();
 }
 
 void RepeatMerger::fillStructure () {
@@ -103,41 +101,61 @@ void RepeatMerger::fillStructure () {
 		}
 	}
 	*/
-	vector <thread> threads(Globals::NB_THREADS);
-	unsigned int i = 1, j = 0, cpt = 0;
-	mutex m;
-	for (int threadId = 0; threadId < Globals::NB_THREADS; threadId++) {
-		threads[threadId] = thread([this, &i, &j, &cpt, &m]() {
-			SequenceComparator comparator;
-			unsigned int thisI, thisJ, thisCpt, nbRepeats = _size, nComparisons = _size * (_size) / 2;
-			while (true) {
-				{
-					lock_guard<mutex> lock(m);
-					thisI = i;
-					thisJ = j;
-					do {
-						j++;
-						if (j >= i) {
-							i++;
-							j = 0;
-						}
-					}
-					while ((i < nbRepeats) && ((_inputRepeats.isRemoved(i)) || (_inputRepeats.isRemoved(j))));
-					cpt++;
-					thisCpt = cpt;
-				}
-				if (thisI >= nbRepeats) {
-					return;
+	PairScheduler               scheduler(_size, Globals::NB_THREADS);
+	vector <SequenceComparator> comparators(max<int>(Globals::NB_THREADS, 1));
+	vector <vector <pair <unsigned int, Comparison> > > cells(comparators.size());
+	atomic <unsigned long>      cpt(0);
+	for (unsigned int i = 0; i < _size; i++) {
+		if (_inputRepeats.isRemoved(i)) {
+			scheduler.remove(i);
+		}
+	}
+	if (Globals::OVERLAP_INDEX) {
+		OverlapIndex  overlapIndex;
+		overlapIndex.build(_inputRepeats);
+		unsigned long nComparisons = overlapIndex.getNbCandidates();
+		scheduler.runRows([this, &overlapIndex, &comparators, &cells, &cpt, nComparisons](unsigned int threadId, unsigned int i, vector <unsigned int> &) {
+			for (unsigned int c = 0; c < overlapIndex.getNbCandidates(i); c++) {
+				compare(comparators[threadId], cells[threadId], i, overlapIndex.getCandidate(i, c));
+				unsigned long thisCpt = ++cpt;
+				if (thisCpt % 10000 == 0) {
+					cout << "\t" << thisCpt << "/" << nComparisons << " comparisons." << endl;
 				}
-				compare(comparator, thisI, thisJ);
+			}
+		});
+	}
+	else {
+		// the pairs which share a short k-mer; the seed index gives the
+		// repeats j > i of the row i
+		SeedIndex                       seedIndex;
+		vector <unsigned int>           minShared(_inputRepeats.getNbRepeats(), 1);
+		vector <vector <unsigned int> > counts(comparators.size());
+		unsigned long                   nComparisons = static_cast<unsigned long>(_size) * _size / 2;
+		seedIndex.build(_inputRepeats);
+		scheduler.runRows([this, &seedIndex, &minShared, &counts, &comparators, &cells, &cpt, nComparisons](unsigned int threadId, unsigned int i, vector <unsigned int> &) {
+			vector <unsigned int> candidates;
+			if (counts[threadId].empty()) {
+				counts[threadId].resize(minShared.size(), 0);
+			}
+			seedIndex.getCandidates(i, minShared, counts[threadId], candidates);
+			for (unsigned int j: candidates) {
+				compare(comparators[threadId], cells[threadId], j, i);
+				unsigned long thisCpt = ++cpt;
 				if (thisCpt % 10000 == 0) {
 					cout << "\t" << thisCpt << "/" << nComparisons << " comparisons." << endl;
 				}
 			}
 		});
 	}
-	for (int threadId = 0; threadId < Globals::NB_THREADS; threadId++) {
-		threads[threadId].join();
+	for (vector <pair <unsigned int, Comparison> > &threadCells: cells) {
+		for (pair <unsigned int, Comparison> &cell: threadCells) {
+			_comparisons[cell.first].push_back(cell.second);
+		}
+		threadCells.clear();
+		threadCells.shrink_to_fit();
+	}
+	for (vector <Comparison> &comparisons: _comparisons) {
+		sort(comparisons.begin(), comparisons.end());
 	}
 	/*
 	if (_j == static_cast<unsigned int>(-1)) {
@@ -146,50 +164,62 @@ void RepeatMerger::fillStructure () {
 	*/
 }
 
-void RepeatMerger::compare(SequenceComparator &comparator, unsigned int i, unsigned int j) {
+// Both ends of the repeats i > j are aligned, in both directions.
+void RepeatMerger::compare(SequenceComparator &comparator, vector <pair <unsigned int, Comparison> > &cells, unsigned int i, unsigned int j) {
 	KmerNb countI = _inputRepeats[i].getCount();
 	KmerNb countJ = _inputRepeats[j].getCount();
 	if (Globals::FREQUENCY_DIFFERENCE * std::min<KmerNb>(countI, countJ) < std::max<KmerNb>(countI, countJ)) {
 		return;
 	}
-	if (! _kmerSets[i].compare(_kmerSets[j])) {
-		return;
-	}
-	string thisWord = _inputRepeats[i].getRepeat().getFirstWord();
-	//if (thisWord.size() > Globals::MAX_MERGE_SIZE) {
-	//	thisWord = thisWord.substr(thisWord.size() - Globals::MAX_MERGE_SIZE, Globals::MAX_MERGE_SIZE);
-	//}
+	const Sequence &thisSequence = _inputRepeats[i].getRepeat();
+	const Sequence &thatSequence = _inputRepeats[j].getRepeat();
+	string thisWord1 = thisSequence.getWord(Globals::DIRECT, max<int>(0, static_cast<int>(thisSequence.getSize()) - Globals::MAX_MERGE_SIZE), Globals::MAX_MERGE_SIZE);
+	string thisWord2 = thisSequence.getWord(Globals::DIRECT, 0, Globals::MAX_MERGE_SIZE);
 	for (int k = 0; k < Globals::DIRECTIONS; k++) {
-		string thatWord = _inputRepeats[j].getRepeat().getWord(k);
-		//if (thatWord.size() > Globals::MAX_MERGE_SIZE) {
-		//	thatWord = thatWord.substr(0, Globals::MAX_MERGE_SIZE);
-		//}
-		string thisWord1 = thisWord.substr(max<int>(0, thisWord.size() - Globals::MAX_MERGE_SIZE), Globals::MAX_MERGE_SIZE);
-		string thatWord1 = thatWord.substr(0, Globals::MAX_MERGE_SIZE);
+		string thatWord1 = thatSequence.getWord(k, 0, Globals::MAX_MERGE_SIZE);
 		comparator.compare(thisWord1, thatWord1);
-		setCell(i, j, k, Globals::AFTER, comparator, thisWord1, thatWord1);
-		//cout << thisWord1 << " and " << thatWord1 << " (" << k << ")\n" << comparator << endl;
-		string thatWord2 = thatWord.substr(max<int>(0, thatWord.size() - Globals::MAX_MERGE_SIZE), Globals::MAX_MERGE_SIZE);
-		string thisWord2 = thisWord.substr(0, Globals::MAX_MERGE_SIZE);
+		setCell(cells, i, j, k, Globals::AFTER, comparator, thisWord1, thatWord1);
+		string thatWord2 = thatSequence.getWord(k, max<int>(0, static_cast<int>(thatSequence.getSize()) - Globals::MAX_MERGE_SIZE), Globals::MAX_MERGE_SIZE);
 		comparator.compare(thatWord2, thisWord2);
-		setCell(i, j, k, Globals::BEFORE, comparator, thatWord2, thisWord2);
-		//cout << thatWord2 << " and " << thisWord2 << " (" << k << ")\n" << comparator << endl;
+		setCell(cells, i, j, k, Globals::BEFORE, comparator, thatWord2, thisWord2);
 	}
 }
 
+// The end of the first word is aligned with the start of the second one.
+// An alignment below MAX_PENALTY has less than MAX_PENALTY / PENALTY_INDEL
+// indels, so it does not leave this band around the diagonals of the seeds.
+void RepeatMerger::compare(SequenceComparator &comparator, vector <pair <unsigned int, Comparison> > &cells, unsigned int i, const OverlapIndex::Candidate &candidate) {
+	unsigned int j      = candidate._other;
+	KmerNb       countI = _inputRepeats[i].getCount();
+	KmerNb       countJ = _inputRepeats[j].getCount();
+	if (Globals::FREQUENCY_DIFFERENCE * std::min<KmerNb>(countI, countJ) < std::max<KmerNb>(countI, countJ)) {
+		return;
+	}
+	int    band     = Globals::MAX_PENALTY / max<Penalty>(Globals::PENALTY_INDEL, 1);
+	const Sequence &thisSequence = _inputRepeats[i].getRepeat();
+	const Sequence &thatSequence = _inputRepeats[j].getRepeat();
+	string first, second;
+	if (candidate._position == Globals::AFTER) {
+		first  = thisSequence.getWord(Globals::DIRECT, max<int>(0, static_cast<int>(thisSequence.getSize()) - Globals::MAX_MERGE_SIZE), Globals::MAX_MERGE_SIZE);
+		second = thatSequence.getWord(candidate._direction, 0, Globals::MAX_MERGE_SIZE);
+	}
+	else {
+		first  = thatSequence.getWord(candidate._direction, max<int>(0, static_cast<int>(thatSequence.getSize()) - Globals::MAX_MERGE_SIZE), Globals::MAX_MERGE_SIZE);
+		second = thisSequence.getWord(Globals::DIRECT, 0, Globals::MAX_MERGE_SIZE);
+	}
+	comparator.compare(first, second, candidate._minDiagonal - band, candidate._maxDiagonal + band);
+	setCell(cells, i, j, candidate._direction, candidate._position, comparator, first, second);
+}
+
 void RepeatMerger::resetMaxPenalty () {
 	Penalty minPenalty    = numeric_limits<Penalty>::max();
 	Penalty maxPenalty    = 0;
 	Penalty middlePenalty = 0;
 	for (unsigned int i = 1; i < _size; i++) {
-		for (unsigned int j = 0; j < i; j++) {
-			for (int k = 0; k < Globals::DIRECTIONS; k++) {
-				for (int l = 0; l < Globals::POSITIONS; l++) {
-					if (isSet(i, j, k, l)) {
-						minPenalty = min<Penalty>(maxPenalty, _comparisons[i][j][k][l].getScore());
-						maxPenalty = max<Penalty>(maxPenalty, _comparisons[i][j][k][l].getScore());
-					}
-				}
+		for (const Comparison &comparison: _comparisons[i]) {
+			if (comparison._other < i) {
+				minPenalty = min<Penalty>(maxPenalty, comparison._data.getScore());
+				maxPenalty = max<Penalty>(maxPenalty, comparison._data.getScore());
 			}
 		}
 	}
@@ -210,54 +240,113 @@ void RepeatMerger::resetMaxPenalty () {
 	_maxPenalty = middlePenalty;
 }
 
+// Union-find over the overlaps which are kept in the graphs.  The repeats
+// of each component are given in increasing order, the component c being
+// ids[starts[c]..starts[c+1]), and the components are sorted by their
+// first repeat.
+void RepeatMerger::findComponents (vector <unsigned int> &starts, vector <unsigned int> &ids) const {
+	vector <unsigned int> parents(_size), components(_size, static_cast<unsigned int>(-1));
+	auto find = [&parents](unsigned int i) {
+		while (parents[i] != i) {
+			parents[i] = parents[parents[i]];
+			i          = parents[i];
+		}
+		return i;
+	};
+	for (unsigned int i = 0; i < _size; i++) {
+		parents[i] = i;
+	}
+	for (unsigned int i = 0; i < _size; i++) {
+		for (const Comparison &comparison: _comparisons[i]) {
+			if ((comparison._other < i) && (comparison._data.getScore() <= _maxPenalty)) {
+				unsigned int root1 = find(i), root2 = find(comparison._other);
+				parents[max<unsigned int>(root1, root2)] = min<unsigned int>(root1, root2);
+			}
+		}
+	}
+	starts.assign(1, 0);
+	for (unsigned int i = 0; i < _size; i++) {
+		if (! _inputRepeats.isRemoved(i)) {
+			unsigned int root = find(i);
+			if (components[root] == static_cast<unsigned int>(-1)) {
+				components[root] = starts.size() - 1;
+				starts.push_back(0);
+			}
+			starts[components[root]+1]++;
+		}
+	}
+	for (unsigned int component = 1; component < starts.size(); component++) {
+		starts[component] += starts[component-1];
+	}
+	vector <unsigned int> positions(starts.begin(), starts.end() - 1);
+	ids.resize(starts.back());
+	for (unsigned int i = 0; i < _size; i++) {
+		if (! _inputRepeats.isRemoved(i)) {
+			ids[positions[components[find(i)]]++] = i;
+		}
+	}
+}
+
+// Each component is explored from its first repeat, in breadth-first order,
+// which gives the indices of the nodes in its graph.  The graphs are solved
+// in parallel, and the merged repeats are added in the order of the
+// components.
 void RepeatMerger::buildGraphs() {
-	set    < unsigned int > pastNodes;
-	vector < unsigned int > currentNodes;
-	for (unsigned int start = 0; start < _size; start++) {
-		if ((! _inputRepeats.isRemoved(start)) && (pastNodes.find(start) == pastNodes.end())) {
-			//cout << "\t\tStarting with " << start << endl;
-			currentNodes.clear();
-			SequenceGraph graph;
-			graph.addNode(0, _inputRepeats[start].getCount(), _inputRepeats[start].getRepeat());
-			currentNodes.push_back(start);
-			for (unsigned int currentIndex = 0; currentIndex < currentNodes.size(); currentIndex++) {
-				unsigned int i = currentNodes[currentIndex];
-				for (unsigned int j = 0; j < _size; j++) {
-					if (j != i) {
-						for (int k = 0; k < Globals::DIRECTIONS; k++) {
-							for (int l = 0; l < Globals::POSITIONS; l++) {
-								if ((isSet(i, j, k, l)) && (getComparison(i, j, k, l).getScore() <= _maxPenalty)) {
-									//cout << "adding " << i << ", " << j << ", " << k << ", " << l << endl;
-									vector<unsigned int>::iterator end = (currentIndex+1 == currentNodes.size())? currentNodes.end(): currentNodes.begin()+currentIndex+1;
-									vector<unsigned int>::iterator it = find(currentNodes.begin(), end, j);
-									unsigned int nextIndex;
-									if (it != end) {
-										nextIndex = it - currentNodes.begin();
-									}
-									else {
-										nextIndex = currentNodes.size();
-										graph.addNode(nextIndex, _inputRepeats[j].getCount(), _inputRepeats[j].getRepeat());
-										currentNodes.push_back(j);
-									}
-									if (i > j) {
-										graph.addLink(currentIndex, l, k, nextIndex);
-									}
-									else {
-										graph.addLink(nextIndex, (k == Globals::DIRECT)? 1-l: l, k, currentIndex);
-									}
-								}
+	vector <unsigned int> starts, ids;
+	findComponents(starts, ids);
+	unsigned int                     nbComponents = starts.size() - 1;
+	unsigned int                     nbThreads    = max<int>(Globals::NB_THREADS, 1);
+	vector <unsigned int>            indices(_size, static_cast<unsigned int>(-1));
+	vector <vector <CountedRepeat> > repeats(nbComponents);
+	atomic <unsigned int>            next(0);
+	vector <thread>                  threads;
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&]() {
+			for (unsigned int component = next++; component < nbComponents; component = next++) {
+				unsigned int            start = ids[starts[component]];
+				vector < unsigned int > currentNodes;
+				SequenceGraph           graph;
+				graph.addNode(0, _inputRepeats[start].getCount(), _inputRepeats[start].getRepeat());
+				currentNodes.push_back(start);
+				indices[start] = 0;
+				for (unsigned int currentIndex = 0; currentIndex < currentNodes.size(); currentIndex++) {
+					unsigned int i = currentNodes[currentIndex];
+					for (const Comparison &comparison: _comparisons[i]) {
+						unsigned int j = comparison._other;
+						short        k = comparison._direction;
+						short        l = comparison._position;
+						if (comparison._data.getScore() <= _maxPenalty) {
+							//cout << "adding " << i << ", " << j << ", " << k << ", " << l << endl;
+							if (indices[j] == static_cast<unsigned int>(-1)) {
+								indices[j] = currentNodes.size();
+								graph.addNode(indices[j], _inputRepeats[j].getCount(), _inputRepeats[j].getRepeat());
+								currentNodes.push_back(j);
+							}
+							unsigned int nextIndex = indices[j];
+							if (i > j) {
+								graph.addLink(currentIndex, l, k, nextIndex);
+							}
+							else {
+								graph.addLink(nextIndex, (k == Globals::DIRECT)? 1-l: l, k, currentIndex);
 							}
 						}
 					}
 				}
+				findPaths(graph, currentNodes, repeats[component]);
 			}
-			findPaths(graph, currentNodes);
-			pastNodes.insert(currentNodes.begin(), currentNodes.end());
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	for (const vector <CountedRepeat> &componentRepeats: repeats) {
+		for (const CountedRepeat &repeat: componentRepeats) {
+			_outputRepeats.addRepeat(repeat);
 		}
 	}
 }
 
-void RepeatMerger::findPaths(SequenceGraph &graph, const vector <unsigned int> &translation) {
+void RepeatMerger::findPaths(SequenceGraph &graph, const vector <unsigned int> &translation, vector <CountedRepeat> &repeats) {
 	//cout << "Before trimming" << endl;
 	//cout << graph << endl;
 	GraphTrimmer trimmer(graph);
@@ -272,7 +361,7 @@ void RepeatMerger::findPaths(SequenceGraph &graph, const vector <unsigned int> &
 	//cout << "\tSmall graph is:\n" << graph << endl;
 	const vector <SequencePath> &pathes = graph.getPathes();
 	for (const SequencePath &path: pathes) {
-		_outputRepeats.addRepeat(mergePath(graph, path, translation));
+		repeats.push_back(mergePath(graph, path, translation));
 	}
 	//cout << "\tAdded repeats." << endl;
 }
@@ -280,11 +369,12 @@ void RepeatMerger::findPaths(SequenceGraph &graph, const vector <unsigned int> &
 CountedRepeat RepeatMerger::mergePath(SequenceGraph &graph, const SequencePath &path, const vector <unsigned int> &translation) {
 	int                 currentId     = path.getNode(0);
 	const SequenceNode &currentNode   = graph.getNode(currentId);
-	string              currentString = currentNode.getSequence().getFirstWord();
-	int                 currentSize   = currentString.size();
+	int                 currentSize   = currentNode.getSequence().getSize();
 	KmerNb              currentCount  = currentNode.getCount();
 	short               position      = -1;
 	short               direction     = -1;
+	PathSpeller         speller;
+	speller.append(currentNode.getSequence(), Globals::DIRECT);
 	//cout << "\tMerging path " << path << endl;
 	//cout << "\t\tstarting with " << currentId << endl;
 	for (unsigned int i = 1; i < path.getSize(); i++) {
@@ -292,7 +382,8 @@ CountedRepeat RepeatMerger::mergePath(SequenceGraph &graph, const SequencePath &
 		short  nextPosition          = path.getNodePosition(i);
 		short  nextDirection         = path.getNodeDirection(i);
 		const SequenceNode &nextNode = graph.getNode(nextId);
-		int    nextSize              = nextNode.getSequence().getSize();
+		const Sequence &nextSequence = nextNode.getSequence();
+		int    nextSize              = nextSequence.getSize();
 		KmerNb nextCount             = nextNode.getCount();
 		if (position == -1) {
 			position  = nextPosition;
@@ -301,7 +392,6 @@ CountedRepeat RepeatMerger::mergePath(SequenceGraph &graph, const SequencePath &
 		else {
 			direction = (nextDirection == Globals::DIRECT)? direction: 1-direction;
 		}
-		string nextString = nextNode.getSequence().getWord(direction);
 		unsigned int thisFirstId, thisSecondId;
 		short        thisPosition, thisDirection;
 		unsigned int translatedCurrentId = translation[currentId], translatedNextId = translation[nextId];
@@ -325,7 +415,7 @@ CountedRepeat RepeatMerger::mergePath(SequenceGraph &graph, const SequencePath &
 		//cout << "current: " << currentId << ", next: " << nextId << ", first: " << thisFirstId << ", second: " << thisSecondId << ", direction: " << thisDirection << ", position: " << thisPosition << endl;
 		//cout << (*this) << endl;
 		//cout << "first: " << thisFirstId << ", " << translation[thisFirstId] << ", second: " << thisSecondId << ", " << translation[thisSecondId] << ", " << _comparisons[translation[thisFirstId]] << " " << _comparisons[translation[thisFirstId]][translation[thisSecondId]] << " " << _comparisons[translation[thisFirstId]][translation[thisSecondId]][thisDirection] << " " << _comparisons[translation[thisFirstId]][translation[thisSecondId]][thisDirection][thisPosition] << endl;
-		const ComparisonData &data = _comparisons[thisFirstId][thisSecondId][thisDirection][thisPosition];
+		const ComparisonData &data = getComparison(thisFirstId, thisSecondId, thisDirection, thisPosition);
 		//cout << "Got " << data << endl;
 		int             startFirst = data.getStartFirst();
 		int             endSecond  = data.getEndSecond();
@@ -380,33 +470,30 @@ CountedRepeat RepeatMerger::mergePath(SequenceGraph &graph, const SequencePath &
 		//int             pos        = ((currentId > nextId) == (thisPosition == Globals::AFTER))? endSecond: startFirst;
 		//cout << "With " << nextSize << " and " << pos << endl;
 		if (position == Globals::AFTER) {
-			//cout << "\t\t\tmerging " << currentString << " and " << nextString << endl;
 			if (thisPosition == Globals::AFTER) {
 				//cout << "case 1" << endl;
-				currentString += nextString.substr(pos, nextSize - pos);
+				speller.append(nextSequence, direction, pos, nextSize - pos);
 			}
 			else {
 				//cout << "case 2 with " << nextSize << " and " << pos << endl;
-				//cout << "cs: " << currentString << ", ns: " << nextString << ", nz: " << nextSize << ", pos: " << pos << ", sf: " << startFirst << ", es: " << endSecond << endl;
-				currentString += nextString.substr(nextSize - pos, pos);
+				speller.append(nextSequence, direction, nextSize - pos, pos);
 			}
 		}
 		else {
-			//cout << "\t\t\tmerging " << nextString << " and " << currentString << endl;
 			if (thisPosition == Globals::BEFORE) {
 				//cout << "case 3" << endl;
-				currentString = nextString.substr(0, pos) + currentString;
+				speller.prepend(nextSequence, direction, 0, pos);
 			}
 			else {
 				//cout << "case 4" << endl;
-				currentString = nextString.substr(nextSize - (pos+1), pos+1) + currentString;
+				speller.prepend(nextSequence, direction, nextSize - (pos+1), pos+1);
 			}
 		}
 		currentCount = (currentCount * currentSize + nextCount * nextSize) / (currentSize + nextSize);
 		currentSize += nextSize;
 		currentId    = nextId;
 	}
-	return CountedRepeat(currentString, currentCount, path.isCycle());
+	return CountedRepeat(speller.getSequence(), currentCount, path.isCycle());
 }
 
 /*
@@ -457,7 +544,6 @@ void RepeatMerger::mergeSequences () {
 	if (newSequence.getSize() >= Globals::MAX_TE_SIZE) {
 		_inputRepeats.removeRepeat(_i);
 	}
-	_kmerSets[_i].setSequence(firstString);
 }
 */
 
@@ -470,15 +556,9 @@ bool RepeatMerger::underPenaltyThreshold (unsigned int threshold) const {
 	for (unsigned int i = 1; i < _size; i++) {
 		if (! _inputRepeats.isRemoved(i)) {
 			nbNeighbors = 0;
-			for (unsigned int j = 0; j < i; j++) {
-				if (! _inputRepeats.isRemoved(j)) {
-					for (int k = 0; k < Globals::DIRECTIONS; k++) {
-						for (int l = 0; l < Globals::POSITIONS; l++) {
-							if ((isSet(i, j, k, l)) && (_comparisons[i][j][k][l].getScore() <= threshold)) {
-								nbNeighbors++;
-							}
-						}
-					}
+			for (const Comparison &comparison: _comparisons[i]) {
+				if ((comparison._other < i) && (! _inputRepeats.isRemoved(comparison._other)) && (comparison._data.getScore() <= threshold)) {
+					nbNeighbors++;
 				}
 			}
 			if (nbNeighbors > Globals::MERGE_MAX_NODES) {
@@ -489,30 +569,33 @@ bool RepeatMerger::underPenaltyThreshold (unsigned int threshold) const {
 	return false;
 }
 
-const ComparisonData &RepeatMerger::getComparison(int i, int j, short direction, short position) const {
-	if (i > j) {
-		return _comparisons[i][j][direction][position];
+// The position is seen from the repeat i.
+const RepeatMerger::Comparison *RepeatMerger::findComparison(unsigned int i, unsigned int j, short k, short l) const {
+	if (i >= _comparisons.size()) {
+		return nullptr;
 	}
-	else {
-		short newPosition = (direction == Globals::DIRECT)? 1-position: position;
-		return _comparisons[j][i][direction][newPosition];
+	Comparison key;
+	key._other     = j;
+	key._direction = k;
+	key._position  = l;
+	auto it = lower_bound(_comparisons[i].begin(), _comparisons[i].end(), key);
+	if ((it == _comparisons[i].end()) || (key < *it)) {
+		return nullptr;
 	}
+	return &(*it);
+}
+
+const ComparisonData &RepeatMerger::getComparison(int i, int j, short direction, short position) const {
+	return findComparison(i, j, direction, position)->_data;
 }
 
 bool RepeatMerger::isSet(unsigned int i, unsigned int j, short k, short l) const {
-	if (i < j) {
-		swap(i, j);
-		if (k == Globals::DIRECT) {
-			l = 1-l;
-		}
-	}
-	if (_comparisons[i].size() <= j) {
-		return false;
-	}
-	return (_comparisons[i][j][k][l].isSet());
+	return (findComparison(i, j, k, l) != nullptr);
 }
 
-void RepeatMerger::setCell(unsigned int i, unsigned int j, short k, short l, SequenceComparator &sc, string &first, string &second) {
+// The comparison is stored in the lists of both repeats.  The cells are
+// local to the thread, and gathered when all the pairs are compared.
+void RepeatMerger::setCell(vector <pair <unsigned int, Comparison> > &cells, unsigned int i, unsigned int j, short k, short l, SequenceComparator &sc, string &first, string &second) {
 	if (i < j) {
 		swap(i, j);
 		if (k == Globals::DIRECT) {
@@ -521,24 +604,25 @@ void RepeatMerger::setCell(unsigned int i, unsigned int j, short k, short l, Seq
 	}
 	ComparisonData cd = ComparisonData(sc, first, second);
 	if ((cd.getScore() < Globals::MAX_PENALTY) && (cd.getIdentity() >= Globals::MIN_IDENTITY)) {
-		if (_comparisons[i].empty()) {
-			_comparisons[i].resize(_size - i + 1);
-		}
-		_comparisons[i][j][k][l] = cd;
+		Comparison comparison;
+		comparison._other     = j;
+		comparison._direction = k;
+		comparison._position  = l;
+		comparison._data      = cd;
+		cells.push_back(make_pair(i, comparison));
+		comparison._other     = i;
+		comparison._position  = (k == Globals::DIRECT)? 1-l: l;
+		cells.push_back(make_pair(j, comparison));
 	}
 }
 
 ostream& operator<<(ostream& output, const RepeatMerger& rm) {
 	output << "Input sequences:\n" << rm._inputRepeats;
 	output << "Output sequences:\n" << rm._outputRepeats;
-	for (unsigned int i = 1; i < rm._size; i++) {
-		for (unsigned int j = 0; j < i; j++) {
-			for (int k = 0; k < Globals::DIRECTIONS; k++) {
-				for (int l = 0; l < Globals::POSITIONS; l++) {
-					if (rm.isSet(i, j, k, l)) {
-						output << i << ", " << j << ", " << l << ", " << k << ":\t" << rm._comparisons[i][j][k][l] << "\n";
-					}
-				}
+	for (unsigned int i = 1; i < rm._comparisons.size(); i++) {
+		for (const RepeatMerger::Comparison &comparison: rm._comparisons[i]) {
+			if (comparison._other < i) {
+				output << i << ", " << comparison._other << ", " << comparison._position << ", " << comparison._direction << ":\t" << comparison._data << "\n";
 			}
 		}
 	}
@@ -21,7 +21,8 @@ along with this program.
 #include <iostream>
 #include "globals.hpp"
 #include "repeats.hpp"
-#include "kmerSet.hpp"
+#include "overlapIndex.hpp"
+#include "seedIndex.hpp"
 #include "sequenceComparator.hpp"
 #include "sequenceGraph.hpp"
 using namespace std;
@@ -92,16 +93,33 @@ class ComparisonData {
 };
 
 
+// The successful comparisons are stored as adjacency lists: each repeat
+// keeps the comparisons with the other repeats, sorted by repeat,
+// direction, and position (seen from the repeat).  The data is the one of
+// the comparison between the greater and the smaller repeat.
+// By default, both ends of the pairs of repeats which share a short k-mer
+// are aligned.  With OVERLAP_INDEX, only the overlaps seeded by the end
+// index are aligned, in a band around the diagonals of their seeds.
 class RepeatMerger {
 
 	private:
+		struct Comparison {
+			unsigned int   _other;
+			short          _direction;
+			short          _position;
+			ComparisonData _data;
+
+			bool operator< (const Comparison &c) const {
+				return (_other != c._other)? (_other < c._other): ((_direction != c._direction)? (_direction < c._direction): (_position < c._position));
+			}
+		};
+
 		unsigned int _size;
 		KmerNb       _minCount;
-		KmerSet*     _kmerSets;
 		Repeats      _inputRepeats;
 		Repeats      _outputRepeats;
 		Penalty      _maxPenalty;
-		vector < vector < array < array < ComparisonData, Globals::POSITIONS > , Globals::DIRECTIONS > > > _comparisons;
+		vector < vector < Comparison > > _comparisons;
 
 	public:
 		RepeatMerger (const Repeats &repeats, const KmerNb minCount = 0);
@@ -114,8 +132,9 @@ class RepeatMerger {
 		void buildStructure ();
 		void cleanStructure ();
 		void fillStructure ();
+		void findComponents(vector <unsigned int> &starts, vector <unsigned int> &ids) const;
 		void buildGraphs();
-		void findPaths(SequenceGraph &graph, const vector <unsigned int> &translation);
+		void findPaths(SequenceGraph &graph, const vector <unsigned int> &translation, vector <CountedRepeat> &repeats);
 		//void findBestMerge ();
 		//void mergeSequences ();
 		CountedRepeat mergePath (SequenceGraph &graph, const SequencePath &path, const vector <unsigned int> &translation);
@@ -123,11 +142,13 @@ class RepeatMerger {
 		void resetMaxPenalty ();
 		bool underPenaltyThreshold (unsigned int threshold) const;
 
+		const Comparison *findComparison(unsigned int i, unsigned int j, short k, short l) const;
 		const ComparisonData &getComparison(int i, int j, short direction, short position) const;
 		bool isSet(unsigned int i, unsigned int j, short k, short l) const;
-		void setCell(unsigned int i, unsigned int j, short k, short l, SequenceComparator &sc, string &first, string &second);
+		void setCell(vector <pair <unsigned int, Comparison> > &cells, unsigned int i, unsigned int j, short k, short l, SequenceComparator &sc, string &first, string &second);
 
-		void compare(SequenceComparator &comparator, unsigned int i, unsigned int j);
+		void compare(SequenceComparator &comparator, vector <pair <unsigned int, Comparison> > &cells, unsigned int i, unsigned int j);
+		void compare(SequenceComparator &comparator, vector <pair <unsigned int, Comparison> > &cells, unsigned int i, const OverlapIndex::Candidate &candidate);
 
 		friend ostream& operator<<(ostream& output, const RepeatMerger& rm);
 };
@@ -69,7 +69,7 @@ class CountedRepeat {
 		bool operator< (const CountedRepeat &cr) const {
 			if (_repeat.getUnambiguousSize() > cr._repeat.getUnambiguousSize()) return true;
 			if ((_repeat.getUnambiguousSize() == cr._repeat.getUnambiguousSize()) && (_count > cr._count)) return true;
-			if ((_repeat.getUnambiguousSize() == cr._repeat.getUnambiguousSize()) && (_count == cr._count) && (_repeat.getFirstWord() < cr._repeat.getFirstWord())) return true;
+			if ((_repeat.getUnambiguousSize() == cr._repeat.getUnambiguousSize()) && (_count == cr._count) && (_repeat < cr._repeat)) return true;
 			return false;
 		}
 		friend ostream& operator<<(ostream& output, const CountedRepeat& cr) {
@@ -21,9 +21,11 @@ along with this program.
 #include <tuple>
 #include <limits>
 #include <algorithm>
+#include <atomic>
 #include "globals.hpp"
 #include "scaffolder.hpp"
 #include "graphTrimmer.hpp"
+#include "pathSpeller.hpp"
 
 
 Scaffolder::Scaffolder (Repeats &r, const char *fileName1, const char *fileName2, unsigned int insertSize): _inputRepeats(r), _fileName1(fileName1), _fileName2(fileName2), _insertSize(insertSize), _maxEvidencesPerNode(1) { }
@@ -386,56 +388,141 @@ void Scaffolder::resetMinEvidences () {
 	_maxEvidencesPerNode = middleEvidences;
 }
 
+// The links which are kept in the graphs, in both directions: each repeat
+// gets the list of its links, sorted by repeat, position, and direction
+// (seen from the repeat).
+void Scaffolder::findLinks (vector < vector < Link > > &links) const {
+	links.assign(_inputRepeats.getNbRepeats(), vector < Link > ());
+	for (const auto &distanceI: _distances) {
+		int i = distanceI.first;
+		for (const auto &distanceIJ: distanceI.second) {
+			int j = distanceIJ.first;
+			if ((j == i) || (_inputRepeats.isRemoved(i)) || (_inputRepeats.isRemoved(j))) {
+				continue;
+			}
+			for (int k = 0; k < Globals::POSITIONS; k++) {
+				for (int l = 0; l < Globals::DIRECTIONS; l++) {
+					const vector <int> &cell = distanceIJ.second[k][l];
+					if ((! cell.empty()) && (cell.size() >= max<unsigned int>(Globals::MIN_SCAFFOLD_KMERS, _maxEvidencesPerNode))) {
+						int mode = computeMode(cell);
+						if ((mode != numeric_limits<int>::min()) && ((mode >= 0) || ((_inputRepeats[i].getSize() >= static_cast<unsigned int>(-mode)) && (_inputRepeats[j].getSize() >= static_cast<unsigned int>(-mode))))) {
+							Link link;
+							link._other     = j;
+							link._position  = k;
+							link._direction = l;
+							links[i].push_back(link);
+							link._other     = i;
+							link._position  = (l == Globals::DIRECT)? 1-k: k;
+							links[j].push_back(link);
+						}
+					}
+				}
+			}
+		}
+	}
+	for (vector < Link > &repeatLinks: links) {
+		sort(repeatLinks.begin(), repeatLinks.end());
+	}
+}
+
+// Union-find over the links.  The repeats of the component c are
+// ids[starts[c]..starts[c+1]), in increasing order, and the components are
+// sorted by their first repeat.
+void Scaffolder::findComponents (const vector < vector < Link > > &links, vector <unsigned int> &starts, vector <unsigned int> &ids) const {
+	unsigned int          nbRepeats = links.size();
+	vector <unsigned int> parents(nbRepeats), components(nbRepeats, static_cast<unsigned int>(-1));
+	auto find = [&parents](unsigned int i) {
+		while (parents[i] != i) {
+			parents[i] = parents[parents[i]];
+			i          = parents[i];
+		}
+		return i;
+	};
+	for (unsigned int i = 0; i < nbRepeats; i++) {
+		parents[i] = i;
+	}
+	for (unsigned int i = 0; i < nbRepeats; i++) {
+		for (const Link &link: links[i]) {
+			unsigned int root1 = find(i), root2 = find(link._other);
+			parents[max<unsigned int>(root1, root2)] = min<unsigned int>(root1, root2);
+		}
+	}
+	starts.assign(1, 0);
+	for (unsigned int i = 0; i < nbRepeats; i++) {
+		if (! _inputRepeats.isRemoved(i)) {
+			unsigned int root = find(i);
+			if (components[root] == static_cast<unsigned int>(-1)) {
+				components[root] = starts.size() - 1;
+				starts.push_back(0);
+			}
+			starts[components[root]+1]++;
+		}
+	}
+	for (unsigned int component = 1; component < starts.size(); component++) {
+		starts[component] += starts[component-1];
+	}
+	vector <unsigned int> positions(starts.begin(), starts.end() - 1);
+	ids.resize(starts.back());
+	for (unsigned int i = 0; i < nbRepeats; i++) {
+		if (! _inputRepeats.isRemoved(i)) {
+			ids[positions[components[find(i)]]++] = i;
+		}
+	}
+}
+
+// The graph of each component is built in breadth-first order from its
+// first repeat.  The graphs are solved in parallel, and the scaffolds are
+// added in the order of the components.
 void Scaffolder::buildGraphs() {
-	set    < unsigned int > pastNodes;
-	vector < unsigned int > currentNodes;
-	for (unsigned int start = 0; start < _inputRepeats.getNbRepeats(); start++) {
-		if ((! _inputRepeats.isRemoved(start)) && (pastNodes.find(start) == pastNodes.end())) {
-			currentNodes.clear();
-			SequenceGraph graph;
-			graph.addNode(0, _inputRepeats[start].getCount(), _inputRepeats[start].getRepeat());
-			currentNodes.push_back(start);
-			//cout << "\t\tadding first: " << start << endl;
-			for (unsigned int currentIndex = 0; currentIndex < currentNodes.size(); currentIndex++) {
-				unsigned int i = currentNodes[currentIndex];
-				for (unsigned int j = 0; j < _inputRepeats.getNbRepeats(); j++) {
-					if ((j != i) && (! _inputRepeats.isRemoved(j))) {
-						for (int k = 0; k < Globals::POSITIONS; k++) {
-							for (int l = 0; l < Globals::DIRECTIONS; l++) {
-								if ((checkCell(i, j, k, l)) && ((getCell(i, j, k, l).size() >= max<unsigned int>(Globals::MIN_SCAFFOLD_KMERS, _maxEvidencesPerNode)))) {
-									int mode = computeMode(getCell(i, j, k, l));
-									if ((mode != numeric_limits<int>::min()) && ((mode >= 0) || ((_inputRepeats[i].getSize() >= static_cast<unsigned int>(-mode)) && (_inputRepeats[j].getSize() >= static_cast<unsigned int>(-mode))))) {
-										//cout << "\t\tadding: " << i << ", " << j << ", " << k << ", " << l << endl;
-										//vector<unsigned int>::iterator end = (currentIndex+1 == currentNodes.size())? currentNodes.end(): currentNodes.begin()+currentIndex+1;
-										//vector<unsigned int>::iterator it = find(currentNodes.begin(), end, j);
-										vector<unsigned int>::iterator it = find(currentNodes.begin(), currentNodes.end(), j);
-										unsigned int nextIndex;
-										//cout << "data:"; for (unsigned int c: currentNodes) cout << " " << c; cout << endl;
-										if (it == currentNodes.end()) {
-											//cout << "\t\t\tfor good" << endl;
-											nextIndex = currentNodes.size();
-											graph.addNode(nextIndex, _inputRepeats[j].getCount(), _inputRepeats[j].getRepeat());
-											currentNodes.push_back(j);
-										}
-										else {
-											nextIndex = it - currentNodes.begin();
-										}
-										graph.addLink(currentIndex, k, l, nextIndex);
-									}
-								}
-							}
+	vector < vector < Link > > links;
+	vector <unsigned int>      starts, ids;
+	findLinks(links);
+	findComponents(links, starts, ids);
+	unsigned int                     nbComponents = starts.size() - 1;
+	unsigned int                     nbThreads    = max<int>(Globals::NB_THREADS, 1);
+	vector <unsigned int>            indices(links.size(), static_cast<unsigned int>(-1));
+	vector <vector <CountedRepeat> > repeats(nbComponents);
+	atomic <unsigned int>            next(0);
+	vector <thread>                  threads;
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&]() {
+			for (unsigned int component = next++; component < nbComponents; component = next++) {
+				unsigned int            start = ids[starts[component]];
+				vector < unsigned int > currentNodes;
+				SequenceGraph           graph;
+				graph.addNode(0, _inputRepeats[start].getCount(), _inputRepeats[start].getRepeat());
+				currentNodes.push_back(start);
+				indices[start] = 0;
+				//cout << "\t\tadding first: " << start << endl;
+				for (unsigned int currentIndex = 0; currentIndex < currentNodes.size(); currentIndex++) {
+					unsigned int i = currentNodes[currentIndex];
+					for (const Link &link: links[i]) {
+						unsigned int j = link._other;
+						//cout << "\t\tadding: " << i << ", " << j << ", " << link._position << ", " << link._direction << endl;
+						if (indices[j] == static_cast<unsigned int>(-1)) {
+							indices[j] = currentNodes.size();
+							graph.addNode(indices[j], _inputRepeats[j].getCount(), _inputRepeats[j].getRepeat());
+							currentNodes.push_back(j);
 						}
+						graph.addLink(currentIndex, link._position, link._direction, indices[j]);
 					}
 				}
+				//cout << "Got this graph:\n" << graph << endl;
+				findPaths(graph, currentNodes, repeats[component]);
 			}
-			//cout << "Got this graph:\n" << graph << endl;
-			findPaths(graph, currentNodes);
-			pastNodes.insert(currentNodes.begin(), currentNodes.end());
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	for (const vector <CountedRepeat> &componentRepeats: repeats) {
+		for (const CountedRepeat &repeat: componentRepeats) {
+			_outputRepeats.addRepeat(repeat);
 		}
 	}
 }
 
-void Scaffolder::findPaths(SequenceGraph &graph, const vector <unsigned int> &translation) {
+void Scaffolder::findPaths(SequenceGraph &graph, const vector <unsigned int> &translation, vector <CountedRepeat> &repeats) {
 	//cout << "Before trimming" << endl;
 	//cout << graph << endl;
 	GraphTrimmer trimmer(graph);
@@ -452,26 +539,27 @@ void Scaffolder::findPaths(SequenceGraph &graph, const vector <unsigned int> &tr
 	//cout << "Graph is:\n" << graph << endl;
 	const vector <SequencePath> &pathes = graph.getPathes();
 	for (const SequencePath &path: pathes) {
-		_outputRepeats.addRepeat(mergePath(graph, path, translation));
+		repeats.push_back(mergePath(graph, path, translation));
 	}
 }
 
 CountedRepeat Scaffolder::mergePath(SequenceGraph &graph, const SequencePath &path, const vector <unsigned int> &translation) {
 	unsigned int        currentId     = path.getNode(0);
 	const SequenceNode &currentNode   = graph.getNode(currentId);
-	string              currentString = currentNode.getSequence().getFirstWord();
-	int                 currentSize   = currentString.size();
+	int                 currentSize   = currentNode.getSequence().getSize();
 	KmerNb              currentCount  = currentNode.getCount();
 	short               position      = -1;
 	short               direction     = -1;
+	PathSpeller         speller;
+	speller.append(currentNode.getSequence(), Globals::DIRECT);
 	//cout << "Current path is " << path << endl;
-	//cout << "\tFirst string: " << currentString << endl;
 	for (unsigned int i = 1; i < path.getSize(); i++) {
 		unsigned int        nextId        = path.getNode(i);
 		short               nextPosition  = path.getNodePosition(i);
 		short               nextDirection = path.getNodeDirection(i);
 		const SequenceNode &nextNode      = graph.getNode(nextId);
-		int                 nextSize      = nextNode.getSequence().getSize();
+		const Sequence     &nextSequence  = nextNode.getSequence();
+		int                 nextSize      = nextSequence.getSize();
 		KmerNb              nextCount     = nextNode.getCount();
 		if (position == -1) {
 			position  = nextPosition;
@@ -480,7 +568,6 @@ CountedRepeat Scaffolder::mergePath(SequenceGraph &graph, const SequencePath &pa
 		else {
 			direction = (nextDirection == Globals::DIRECT)? direction: 1-direction;
 		}
-		string       nextString = nextNode.getSequence().getWord(direction), firstString, secondString, fill;
 		int          thisFirstId, thisSecondId;
 		short        thisPosition, thisDirection;
 		unsigned int translatedCurrentId = translation[currentId], translatedNextId = translation[nextId];
@@ -496,36 +583,39 @@ CountedRepeat Scaffolder::mergePath(SequenceGraph &graph, const SequencePath &pa
 			thisPosition  = (nextDirection == Globals::DIRECT)? 1-nextPosition: nextPosition;
 			thisDirection = nextDirection;
 		}
-		firstString  = (position == Globals::AFTER)? currentString: nextString;
-		secondString = (position == Globals::AFTER)? nextString: currentString;
-		/*
-		firstString  = ((currentId > nextId) == (position == Globals::AFTER) == (nextDirection == Globals::DIRECT))? currentString: nextString;
-		secondString = ((currentId > nextId) == (position == Globals::AFTER) == (nextDirection == Globals::DIRECT))? nextString: currentString;
-		*/
-		int distance = computeMode(getCell(thisFirstId, thisSecondId, thisPosition, thisDirection));
+		int distance         = computeMode(getCell(thisFirstId, thisSecondId, thisPosition, thisDirection));
+		int accurateDistance = 0;
 		//int distance = _modes[thisFirstId][thisSecondId][thisPosition][thisDirection];
 		//cout << "distance 1: " << distance << endl;
 		if (distance < 0) {
 			//cout << "distance: " << distance << endl;
-			int accurateDistance = stitch(firstString, secondString, _distances[thisFirstId][thisSecondId][thisPosition][thisDirection]);
-			//cout << "Stitched. Check that " << firstString.substr(firstString.size()-accurateDistance, accurateDistance) << " is somehow similar to " << secondString.substr(0, accurateDistance) << endl;
-			if (accurateDistance > 0) {
-				secondString = secondString.substr(accurateDistance);
+			const vector <int> &distances  = getCell(thisFirstId, thisSecondId, thisPosition, thisDirection);
+			unsigned int        stitchSize = getStitchSize(distances);
+			string              nextString = nextSequence.getWord(direction);
+			if (position == Globals::AFTER) {
+				accurateDistance = stitch(speller.getSuffix(stitchSize), nextString, distances);
+			}
+			else {
+				accurateDistance = stitch(nextString, speller.getPrefix(stitchSize), distances);
 			}
+			accurateDistance = max<int>(accurateDistance, 0);
 			distance = 0;
 		}
 		//cout << "distance 2: " << distance << endl;
-		if (distance > 0) {
-			fill = string(distance, 'N');
+		if (position == Globals::AFTER) {
+			speller.appendGap(distance);
+			speller.append(nextSequence, direction, accurateDistance);
+		}
+		else {
+			speller.trimFront(accurateDistance);
+			speller.prependGap(distance);
+			speller.prepend(nextSequence, direction);
 		}
-		currentString = firstString + fill + secondString;
 		currentCount  = (currentCount * currentSize + nextCount * nextSize) / (currentSize + nextSize);
 		currentSize  += nextSize;
 		currentId     = nextId;
-		//cout << "\tAdding strings: " << firstString << ", " << secondString << ", currentId: " << currentId << ", nextId: " << nextId << ", thisPosition: " << thisPosition << ", thisDirection " << thisDirection << ", nextPosition: " << nextPosition << ", nextDirection: " << nextDirection << endl;
 	}
-	//cout << "current string: " << currentString << endl;
-	return CountedRepeat(currentString, currentCount, path.isCycle());
+	return CountedRepeat(speller.getSequence(), currentCount, path.isCycle());
 }
 
 /*
@@ -622,12 +712,12 @@ bool Scaffolder::checkCell(int i, int j, short position, short direction) const
 	return (! distanceIJ[position][direction].empty());
 }
 
-const vector <int> &Scaffolder::getCell(int i, int j, short position, short direction) {
+const vector <int> &Scaffolder::getCell(int i, int j, short position, short direction) const {
 	if (i > j) {
-		return _distances[i][j][position][direction];
+		return _distances.at(i).at(j)[position][direction];
 	}
 	short newPosition = (direction == Globals::DIRECT)? 1-position: position;
-	return _distances[j][i][newPosition][direction];
+	return _distances.at(j).at(i)[newPosition][direction];
 }
 
 void Scaffolder::setCell(const int i, const int j, const short position, const short direction, const vector <int>&values) {
@@ -652,10 +742,16 @@ void Scaffolder::freeCell(const int i, const int j, const short position, const
 	}
 }
 
+// Only the last (resp. first) nucleotides of the first (resp. second)
+// sequence are used to stitch them.
+unsigned int Scaffolder::getStitchSize(const vector <int> &v) const {
+	return max<int>(0, -(*min_element(v.begin(), v.end())));
+}
+
 int Scaffolder::stitch(const string &seq1, const string &seq2, const vector <int> &v) const {
 	//cout << "mode: " << ", min: " << (*min_element(v.begin(), v.end())) << ", max: " << (*max_element(v.begin(), v.end())) << endl;
 	int minSize = min<int>(0, -(*max_element(v.begin(), v.end())));
-	int maxSize = max<int>(0, -(*min_element(v.begin(), v.end())));
+	int maxSize = getStitchSize(v);
 	string s1 = seq1.substr(seq1.size()-min<int>(maxSize, seq1.size()), min<int>(maxSize, seq1.size()));
 	string s2 = seq2.substr(0, min<int>(maxSize, seq2.size()));
 	int maxStart = s1.size() - 1 - (maxSize - minSize);
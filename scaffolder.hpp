@@ -34,6 +34,16 @@ using namespace std;
 class Scaffolder {
 
     private:
+		struct Link {
+			unsigned int _other;
+			short        _position;
+			short        _direction;
+
+			bool operator< (const Link &l) const {
+				return (_other != l._other)? (_other < l._other): ((_position != l._position)? (_position < l._position): (_direction < l._direction));
+			}
+		};
+
 		map < int, map < int, array < array < vector < int >, Globals::DIRECTIONS >, Globals::POSITIONS > > > _distances;
 		//vector < vector < array < array < int, Globals::DIRECTIONS >, Globals::POSITIONS > > > _modes;
 		map < string, vector < tuple < int, int, short > > >  _kmers;
@@ -59,18 +69,21 @@ class Scaffolder {
 		//void checkDistances();
 		//tuple <int, int, short, short> findBestScaffold () const;
 		void resetMinEvidences ();
+		void findLinks (vector < vector < Link > > &links) const;
+		void findComponents (const vector < vector < Link > > &links, vector <unsigned int> &starts, vector <unsigned int> &ids) const;
 		void buildGraphs();
-		void findPaths(SequenceGraph &graph, const vector <unsigned int> &translation);
+		void findPaths(SequenceGraph &graph, const vector <unsigned int> &translation, vector <CountedRepeat> &repeats);
 		CountedRepeat mergePath(SequenceGraph &graph, const SequencePath &path, const vector <unsigned int> &translation);
 		bool mergeSequences (const int i, const int j, const short position, const short direction, int distance);
 
 		void updateCount (int repeat1, int repeatPos1, int readPos1, short strand1, int lineSize1, int repeat2, int repeatPos2, int readPos2, short strand2, int lineSize2, mutex &m);
 
 		bool checkCell(int i, int j, short position, short direction) const;
-		const vector <int>&getCell(int i, int j, short position, short direction);
+		const vector <int>&getCell(int i, int j, short position, short direction) const;
 		void setCell(const int i, const int j, const short position, const short direction, const vector <int>&values);
 		void freeCell(const int i, const int j, const short position, const short direction);
 
+		unsigned int getStitchSize(const vector <int> &v) const;
 		int stitch(const string &seq1, const string &seq2, const vector <int> &v) const;
 		pair <int, int> localAlignment(const string &s1, const string &s2, const unsigned int maxStart, const unsigned int maxEnd) const;
 
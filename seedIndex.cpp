@@ -0,0 +1,104 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <algorithm>
+#include <thread>
+#include "seedIndex.hpp"
+
+SeedIndex::SeedIndex () { }
+
+// The sketches of the repeats are computed in parallel, then all the
+// (seed, repeat) pairs are sorted, so that each seed gets its list.
+void SeedIndex::build (const Repeats &repeats) {
+	unsigned int          nbRepeats = repeats.getNbRepeats();
+	unsigned int          nbThreads = max<int>(Globals::NB_THREADS, 1);
+	vector <KmerSketch>   sketches(nbRepeats);
+	vector <thread>       threads;
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int i = threadId; i < nbRepeats; i += nbThreads) {
+				if (! repeats.isRemoved(i)) {
+					sketches[i].setSequence(repeats[i].getRepeat().getFirstWord());
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	vector <pair <uint64_t, unsigned int> > pairs;
+	_seedStarts.assign(1, 0);
+	_sizes.resize(nbRepeats);
+	for (unsigned int i = 0; i < nbRepeats; i++) {
+		for (uint64_t seed: sketches[i].getHashes()) {
+			pairs.push_back(make_pair(seed, i));
+		}
+		_seedStarts.push_back(pairs.size());
+		_sizes[i] = sketches[i].getSize();
+		sketches[i] = KmerSketch();
+	}
+	sort(pairs.begin(), pairs.end());
+	vector <unsigned int> positions(_seedStarts.begin(), _seedStarts.end() - 1);
+	_starts.clear();
+	_ids.resize(pairs.size());
+	_seeds.resize(pairs.size());
+	for (unsigned int i = 0; i < pairs.size(); i++) {
+		if ((i == 0) || (pairs[i].first != pairs[i-1].first)) {
+			_starts.push_back(i);
+		}
+		_ids[i] = pairs[i].second;
+		_seeds[positions[pairs[i].second]++] = _starts.size() - 1;
+	}
+	_starts.push_back(pairs.size());
+}
+
+unsigned int SeedIndex::getNbSeeds (const unsigned int i) const {
+	return _sizes[i];
+}
+
+// Give the repeats j > i which share at least minShared[j] seeds with the
+// repeat i, in increasing order.  The counts should be set to 0, and have
+// one cell per repeat; they are set to 0 again at the end.
+void SeedIndex::getCandidates (const unsigned int i, const vector <unsigned int> &minShared, vector <unsigned int> &counts, vector <unsigned int> &candidates) const {
+	vector <unsigned int> touched;
+	candidates.clear();
+	for (unsigned int s = _seedStarts[i]; s < _seedStarts[i+1]; s++) {
+		unsigned int seed = _seeds[s];
+		for (auto it = upper_bound(_ids.begin() + _starts[seed], _ids.begin() + _starts[seed+1], i); it != _ids.begin() + _starts[seed+1]; ++it) {
+			if (counts[*it]++ == 0) {
+				touched.push_back(*it);
+			}
+		}
+	}
+	for (unsigned int j: touched) {
+		if (counts[j] >= minShared[j]) {
+			candidates.push_back(j);
+		}
+		counts[j] = 0;
+	}
+	sort(candidates.begin(), candidates.end());
+}
+
+void SeedIndex::clear () {
+	_starts.clear();
+	_ids.clear();
+	_seedStarts.clear();
+	_seeds.clear();
+	_sizes.clear();
+}
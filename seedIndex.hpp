@@ -0,0 +1,49 @@
+/**
+Copyright (C) 2013 INRA-URGI
+This file is part of TEDNA, a short reads transposable elements assembler
+TEDNA is free software: you can redistribute it and/or modify
+it under the terms of the GNU Affero General Public License as
+published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+GNU Affero General Public License for more details.
+See the GNU Affero General Public License for more details.
+You should have received a copy of the GNU Affero General Public License
+along with this program.
+**/
+#ifndef SEED_INDEX_HPP
+#define SEED_INDEX_HPP 1
+
+#include <string>
+#include <vector>
+#include "globals.hpp"
+#include "repeats.hpp"
+#include "kmerSketch.hpp"
+using namespace std;
+
+// Inverted index from the short k-mers (the seeds) to the repeats which
+// contain them.  The seeds are the hashes of the sketches of the repeats,
+// so that a repeat shares all its seeds with its reverse complement.
+// The repeats of a seed are stored in increasing order, in
+// _ids[_starts[s].._starts[s+1]), and the seeds of the repeat i are
+// _seeds[_seedStarts[i].._seedStarts[i+1]).
+class SeedIndex {
+
+	private:
+		vector <unsigned int> _starts;
+		vector <unsigned int> _ids;
+		vector <unsigned int> _seedStarts;
+		vector <unsigned int> _seeds;
+		vector <unsigned int> _sizes;
+
+	public:
+		SeedIndex ();
+		void build (const Repeats &repeats);
+		unsigned int getNbSeeds (const unsigned int i) const;
+		void getCandidates (const unsigned int i, const vector <unsigned int> &minShared, vector <unsigned int> &counts, vector <unsigned int> &candidates) const;
+		void clear ();
+};
+
+#endif
@@ -18,89 +18,123 @@ along with this program.
 #endif
 
 #include <cmath>
+#include <algorithm>
 #include <sstream>
 #include "globals.hpp"
 #include "sequence.hpp"
 
 
-Sequence::Sequence() {}
+constexpr unsigned int Sequence::NUCLEOTIDES_PER_BLOCK;
 
-Sequence::Sequence(const string &word): _firstWord(word) {
-	computeSecondWord();
+
+Sequence::Sequence(): _start(0), _size(0), _reverse(false) {}
+
+Sequence::Sequence(const string &word): _start(0), _size(0), _reverse(false) {
+	append(word);
+	updateWords();
 }
 
 
-Sequence::Sequence(const Sequence &s): _firstWord(s._firstWord), _secondWord(s._secondWord) { }
+Sequence::Sequence(const Sequence &s): _codes(s._codes), _others(s._others), _start(s._start), _size(s._size), _reverse(s._reverse) { }
 
 
 const bool Sequence::empty() const {
-	return _firstWord.empty();
+	return (_size == 0);
 }
 
 
 const unsigned int Sequence::getSize() const {
-	return _firstWord.size();
+	return _size;
 }
 
 const unsigned int Sequence::getUnambiguousSize() const {
-	unsigned int size = 0;
-	for (char c: _firstWord) {
-		switch (c) {
-			case 'A':
-			case 'C':
-			case 'G':
-			case 'T':
+	unsigned int size = _size;
+	for (const pair <unsigned int, char> &other: _others) {
+		switch (other.second) {
 			case 'a':
 			case 'c':
 			case 'g':
 			case 't':
-				size++;
+				break;
+			default:
+				size--;
 		}
 	}
 	return size;
 }
 
-const string &Sequence::getFirstWord() const {
-    return _firstWord;
+string Sequence::getFirstWord() const {
+    return getWord(Globals::DIRECT);
 }
 
 
-const string &Sequence::getSecondWord() const {
-    return _secondWord;
+string Sequence::getSecondWord() const {
+    return getWord(Globals::REVERSE);
+}
+
+
+string Sequence::getWord(const short i) const {
+	return getWord(i, 0, _size);
+}
+
+
+// The nucleotides [start, start + size) of a strand, clipped to the sequence.
+string Sequence::getWord(const short i, const unsigned int start, const unsigned int size) const {
+	if (start >= _size) {
+		return string();
+	}
+	unsigned int end = start + min<unsigned int>(size, _size - start);
+	string word(end - start, 'A');
+	for (unsigned int j = start; j < end; j++) {
+		word[j - start] = getNucleotide(j, i);
+	}
+	return word;
 }
 
 
-const string &Sequence::getWord(const short i) const {
-	return (i == Globals::DIRECT)? _firstWord: _secondWord;
+char Sequence::getNucleotide(const unsigned int i, const short direction) const {
+	if ((direction == Globals::DIRECT) != _reverse) {
+		return getChar(i);
+	}
+	return Globals::getComplement(getChar(_size - 1 - i));
 }
 
 
 void Sequence::setFirstWord(const string &word) {
-	_firstWord = word;
-	computeSecondWord();
+	clear();
+	append(word);
+	updateWords();
 }
 
 
 bool Sequence::addFront(const string &nucleotides) {
-	_firstWord.insert(0, nucleotides);
-	return (computeSecondWord());
+	if (_reverse) {
+		append(Globals::getReverseComplement(nucleotides));
+	}
+	else {
+		prepend(nucleotides);
+	}
+	return updateWords();
 }
 
 
 bool Sequence::addBack(const string &nucleotides) {
-	_firstWord.append(nucleotides);
-	return (computeSecondWord());
+	if (_reverse) {
+		prepend(Globals::getReverseComplement(nucleotides));
+	}
+	else {
+		append(nucleotides);
+	}
+	return updateWords();
 }
 
 
 bool Sequence::addCode(const int code) {
 	if (code < 0) {
-		addFront(string(1, Globals::getNucleotide(-code-1)));
-		return updateWords();
+		return addFront(string(1, Globals::getNucleotide(-code-1)));
 	}
 	if (code > 0) {
-		addBack(string(1, Globals::getNucleotide(code-1)));
-		return updateWords();
+		return addBack(string(1, Globals::getNucleotide(code-1)));
 	}
 	cerr << "Cannot use code 0 for " << *this << endl;
 	return false;
@@ -108,57 +142,224 @@ bool Sequence::addCode(const int code) {
 
 
 void Sequence::clear() {
-	if (! empty()) {
-		_firstWord.clear();
-		_secondWord.clear();
-	}
+	_codes.clear();
+	_others.clear();
+	_start   = 0;
+	_size    = 0;
+	_reverse = false;
 }
 
 
+// Sets the strand of the first word, and tells whether it has changed.
+// A palindrome keeps its strand.
 bool Sequence::updateWords() {
-	if (_secondWord < _firstWord) {
-		swap(_firstWord, _secondWord);
-		return true;
+	int  comparison = compareStrands();
+	bool reverse    = (comparison < 0)? true: ((comparison > 0)? false: _reverse);
+	bool changed    = (reverse != _reverse);
+	_reverse        = reverse;
+	return changed;
+}
+
+
+// Compares the reverse complement of the stored strand with the stored strand.
+int Sequence::compareStrands() const {
+	for (unsigned int i = 0; i < _size; i++) {
+		char forward = getChar(i), reverse = Globals::getComplement(getChar(_size - 1 - i));
+		if (forward != reverse) {
+			return (reverse < forward)? -1: 1;
+		}
 	}
-	return false;
+	return 0;
 }
 
 
-bool Sequence::computeSecondWord() {
-	_secondWord = Globals::getReverseComplement(_firstWord);
+char Sequence::getChar(const unsigned int position) const {
+	unsigned int index = _start + position;
+	if (! _others.empty()) {
+		auto it = lower_bound(_others.begin(), _others.end(), index, [](const pair <unsigned int, char> &other, const unsigned int i) { return other.first < i; });
+		if ((it != _others.end()) && (it->first == index)) {
+			return it->second;
+		}
+	}
+	return Globals::getNucleotide(getBits(index));
+}
+
+
+// The 2 bits code at an index of _codes (the other characters are coded as A).
+uint64_t Sequence::getBits(const unsigned int index) const {
+	return (_codes[index / NUCLEOTIDES_PER_BLOCK] >> (Globals::NB_BITS_NUCLEOTIDES * (index % NUCLEOTIDES_PER_BLOCK))) & Globals::NUCLEOTIDE_MASK;
+}
+
+
+void Sequence::setBits(const unsigned int index, const uint64_t code) {
+	uint64_t     &block = _codes[index / NUCLEOTIDES_PER_BLOCK];
+	unsigned int  shift = Globals::NB_BITS_NUCLEOTIDES * (index % NUCLEOTIDES_PER_BLOCK);
+	block = (block & ~(static_cast<uint64_t>(Globals::NUCLEOTIDE_MASK) << shift)) | (code << shift);
+}
+
+
+void Sequence::setChar(const unsigned int index, const char c, vector <pair <unsigned int, char> > &others) {
+	uint64_t code = 0;
+	switch (c) {
+		case 'A':
+		case 'C':
+		case 'G':
+		case 'T':
+			code = Globals::getCode(c);
+			break;
+		default:
+			others.push_back(make_pair(index, c));
+	}
+	setBits(index, code);
+}
+
+
+// Makes room for size nucleotides before the sequence.
+void Sequence::reserveFront(const unsigned int size) {
+	if (_start < size) {
+		unsigned int nbBlocks = (size + _size) / NUCLEOTIDES_PER_BLOCK + 1;
+		_codes.insert(_codes.begin(), nbBlocks, 0);
+		_start += nbBlocks * NUCLEOTIDES_PER_BLOCK;
+		for (pair <unsigned int, char> &other: _others) {
+			other.first += nbBlocks * NUCLEOTIDES_PER_BLOCK;
+		}
+	}
+}
+
+
+// Makes room for size nucleotides after the sequence.
+void Sequence::reserveBack(const unsigned int size) {
+	unsigned int end = _start + _size + size;
+	if (end > _codes.size() * NUCLEOTIDES_PER_BLOCK) {
+		_codes.resize(max<size_t>(end / NUCLEOTIDES_PER_BLOCK + 1, 2 * _codes.size()), 0);
+	}
+}
+
+
+void Sequence::prepend(const string &nucleotides) {
+	unsigned int size = nucleotides.size();
+	vector <pair <unsigned int, char> > others;
+	reserveFront(size);
+	_start -= size;
+	_size  += size;
+	for (unsigned int i = 0; i < size; i++) {
+		setChar(_start + i, nucleotides[i], others);
+	}
+	_others.insert(_others.begin(), others.begin(), others.end());
+}
+
+
+void Sequence::append(const string &nucleotides) {
+	unsigned int size = nucleotides.size();
+	reserveBack(size);
+	for (unsigned int i = 0; i < size; i++) {
+		setChar(_start + _size + i, nucleotides[i], _others);
+	}
+	_size += size;
+}
+
+
+// Copies the nucleotides start..start+size-1 of a word of k, before or
+// after the stored strand, from the packed codes.
+void Sequence::insert(const Sequence &k, const short direction, const unsigned int start, const unsigned int size, const short position) {
+	bool         forward = ((direction == Globals::DIRECT) != k._reverse);
+	unsigned int first   = (forward)? k._start + start: k._start + k._size - start - size;
+	unsigned int to;
+	vector <pair <unsigned int, char> > others;
+	if (position == Globals::BEFORE) {
+		reserveFront(size);
+		_start -= size;
+		to      = _start;
+	}
+	else {
+		reserveBack(size);
+		to = _start + _size;
+	}
+	_size += size;
+	for (unsigned int i = 0; i < size; i++) {
+		if (forward) {
+			setBits(to + i, k.getBits(first + i));
+		}
+		else {
+			setBits(to + i, Globals::getComplementCode(k.getBits(first + size - 1 - i)));
+		}
+	}
+	// the other characters of the range, in increasing order in the copy
+	auto compare = [](const pair <unsigned int, char> &other, const unsigned int i) { return other.first < i; };
+	auto begin   = lower_bound(k._others.begin(), k._others.end(), first, compare);
+	auto end     = lower_bound(begin, k._others.end(), first + size, compare);
+	if (forward) {
+		for (auto it = begin; it != end; ++it) {
+			setChar(to + it->first - first, it->second, others);
+		}
+	}
+	else {
+		for (auto it = end; it != begin; --it) {
+			setChar(to + first + size - 1 - prev(it)->first, Globals::getComplement(prev(it)->second), others);
+		}
+	}
+	_others.insert((position == Globals::BEFORE)? _others.begin(): _others.end(), others.begin(), others.end());
+}
+
+
+// Adds the nucleotides start..start+size-1 of a word of k before or after
+// the first word, and tells whether the strand of the first word has changed.
+bool Sequence::add(const Sequence &k, const short direction, const unsigned int start, const unsigned int size, const short position) {
+	if (&k == this) {
+		Sequence copy(k);
+		return add(copy, direction, start, size, position);
+	}
+	if (_reverse) {
+		insert(k, 1-direction, k._size - start - size, size, 1-position);
+	}
+	else {
+		insert(k, direction, start, size, position);
+	}
 	return updateWords();
 }
 
 
+// Tells whether the nucleotides thisStart... of the first word are the
+// nucleotides thatStart... of a word of k.
+bool Sequence::matches(const unsigned int thisStart, const Sequence &k, const short direction, const unsigned int thatStart, const int size) const {
+	for (int i = 0; i < size; i++) {
+		if (getNucleotide(thisStart + i) != k.getNucleotide(thatStart + i, direction)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
 const short Sequence::compareNext(const Sequence &k, const short position) const {
 	unsigned int thisSize = getSize(), thatSize = k.getSize();
 	int last = min<unsigned int>(thisSize, thatSize) - 1;
 	if ((position == Globals::AFTER) || (position == Globals::POSITIONS)) {
-		if (k.getFirstWord().substr(0, last) == getFirstWord().substr(thisSize-last, last)) {
+		if (matches(thisSize-last, k, Globals::DIRECT, 0, last)) {
 			if (position == Globals::AFTER) {
 				return Globals::DIRECT;
 			}
-			return Globals::getCode(k.getFirstWord()[last]) + 1;
+			return Globals::getCode(k.getNucleotide(last, Globals::DIRECT)) + 1;
 		}
-		if (k.getSecondWord().substr(0, last) == getFirstWord().substr(thisSize-last, last)) {
+		if (matches(thisSize-last, k, Globals::REVERSE, 0, last)) {
 			if (position == Globals::AFTER) {
 				return Globals::REVERSE;
 			}
-			return Globals::getCode(k.getSecondWord()[last]) + 1;
+			return Globals::getCode(k.getNucleotide(last, Globals::REVERSE)) + 1;
 		}
 	}
 	else if ((position == Globals::BEFORE) || (position == Globals::POSITIONS)) {
-		if (k.getFirstWord().substr(thatSize-last, last) == getFirstWord().substr(0, last)) {
+		if (matches(0, k, Globals::DIRECT, thatSize-last, last)) {
 			if (position == Globals::BEFORE) {
 				return Globals::DIRECT;
 			}
-			return -(Globals::getCode(k.getFirstWord()[0]) + 1);
+			return -(Globals::getCode(k.getNucleotide(0, Globals::DIRECT)) + 1);
 		}
-		if (k.getSecondWord().substr(thatSize-last, last) == getFirstWord().substr(0, last)) {
+		if (matches(0, k, Globals::REVERSE, thatSize-last, last)) {
 			if (position == Globals::BEFORE) {
 				return Globals::REVERSE;
 			}
-			return -(Globals::getCode(k.getSecondWord()[0]) + 1);
+			return -(Globals::getCode(k.getNucleotide(0, Globals::REVERSE)) + 1);
 		}
 	}
 	return 0;
@@ -185,26 +386,26 @@ tuple<short, short, bool> Sequence::merge(const Sequence &k, short direction, in
 	//cout << "\tMerging " << *this << " with " << k << " and direction " << direction;
 	for (int size = maxSize; size >= minSize; size--) {
 		if (direction != Globals::BEFORE) {
-			if (k.getFirstWord().substr(0, size) == getFirstWord().substr(thisSize-size, size)) {
+			if (matches(thisSize-size, k, DIRECT, 0, size)) {
 				//cout << " is " << *this << " (size: " << thisSize << ", " << thatSize << ", " << size << ", case 1)" << endl;
-				bool reverse = addBack(k.getFirstWord().substr(size, thatSize-size));
+				bool reverse = add(k, DIRECT, size, thatSize-size, AFTER);
 				return make_tuple(AFTER, DIRECT, reverse);
 			}
-			if (k.getSecondWord().substr(0, size) == getFirstWord().substr(thisSize-size, size)) {
+			if (matches(thisSize-size, k, REVERSE, 0, size)) {
 				//cout << " is " << *this << " (size: " << thisSize << ", " << thatSize << ", " << size << ", case 2)" << endl;
-				bool reverse = addBack(k.getSecondWord().substr(size, thatSize-size));
+				bool reverse = add(k, REVERSE, size, thatSize-size, AFTER);
 				return make_tuple(AFTER, REVERSE, reverse);
 			}
 		}
 		if (direction != Globals::AFTER) {
-			if (k.getFirstWord().substr(thatSize-size, size) == getFirstWord().substr(0, size)) {
+			if (matches(0, k, DIRECT, thatSize-size, size)) {
 				//cout << " is " << *this << " (size: " << thisSize << ", " << thatSize << ", " << size << ", case 3)" << endl;
-				bool reverse = addFront(k.getFirstWord().substr(0, thatSize-size));
+				bool reverse = add(k, DIRECT, 0, thatSize-size, BEFORE);
 				return make_tuple(BEFORE, DIRECT, reverse);
 			}
-			if (k.getSecondWord().substr(thatSize-size, size) == getFirstWord().substr(0, size)) {
+			if (matches(0, k, REVERSE, thatSize-size, size)) {
 				//cout << " is " << *this << " (size: " << thisSize << ", " << thatSize << ", " << size << ", case 4)" << endl;
-				bool reverse = addFront(k.getSecondWord().substr(0, thatSize-size));
+				bool reverse = add(k, REVERSE, 0, thatSize-size, BEFORE);
 				return make_tuple(BEFORE, REVERSE, reverse);
 			}
 		}
@@ -215,7 +416,24 @@ tuple<short, short, bool> Sequence::merge(const Sequence &k, short direction, in
 }
 
 bool Sequence::isAmbiguous () const {
-	for (char c: _firstWord) {
+	for (const pair <unsigned int, char> &other: _others) {
+		switch(other.second) {
+			case 'a':
+			case 'c':
+			case 'g':
+			case 't':
+			case 'U':
+			case 'u':
+				break;
+			default:
+				return true;
+		}
+	}
+	return false;
+}
+
+bool Sequence::isAmbiguous (const string &word) {
+	for (char c: word) {
 		switch(c) {
 			case 'A':
 			case 'a':
@@ -236,13 +454,32 @@ bool Sequence::isAmbiguous () const {
 }
 
 bool Sequence::isLowComplexity () const {
-	bool  nucleotides[Globals::NB_NUCLEOTIDES];
+	bool  nucleotides[Globals::NB_NUCLEOTIDES+1];
 	short nbNucleotides = 0;
-	for (int i = 0; i < Globals::NB_NUCLEOTIDES; i++) {
+	for (int i = 0; i <= Globals::NB_NUCLEOTIDES; i++) {
 		nucleotides[i] = false;
 	}
-	for (unsigned int i = 0; i < _firstWord.length(); i++) {
-		short code = Globals::getCode(_firstWord[i]);
+	for (unsigned int i = 0; i < _size; i++) {
+		short code = Globals::getCode(getChar(i));
+		if (! nucleotides[code]) {
+			nbNucleotides++;
+			if (nbNucleotides >= 3) {
+				return false;
+			}
+			nucleotides[code] = true;
+		}
+	}
+	return true;
+}
+
+bool Sequence::isLowComplexity (const string &word) {
+	bool  nucleotides[Globals::NB_NUCLEOTIDES+1];
+	short nbNucleotides = 0;
+	for (int i = 0; i <= Globals::NB_NUCLEOTIDES; i++) {
+		nucleotides[i] = false;
+	}
+	for (unsigned int i = 0; i < word.length(); i++) {
+		short code = Globals::getCode(word[i]);
 		if (! nucleotides[code]) {
 			nbNucleotides++;
 			if (nbNucleotides >= 3) {
@@ -256,21 +493,40 @@ bool Sequence::isLowComplexity () const {
 
 string Sequence::printFasta(string title) const {
 	stringstream fastaString;
-	string word     = _firstWord;
+	string word     = getFirstWord();
 	int    lineSize = 60;
-	fastaString << ">" << title << " (" << _firstWord.size() << ")";
-	for (unsigned int i = 0; i <= _firstWord.length()/lineSize; i++) {
-		fastaString << "\n" << _firstWord.substr(i*lineSize, lineSize);
+	fastaString << ">" << title << " (" << word.size() << ")";
+	for (unsigned int i = 0; i <= word.length()/lineSize; i++) {
+		fastaString << "\n" << word.substr(i*lineSize, lineSize);
 	}
 	fastaString << "\n";
 	return fastaString.str();
 }
 
 bool operator==(const Sequence &s1, const Sequence &s2) {
-	return (s1._firstWord == s2._firstWord);
+	if (s1._size != s2._size) {
+		return false;
+	}
+	for (unsigned int i = 0; i < s1._size; i++) {
+		if (s1.getNucleotide(i) != s2.getNucleotide(i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool operator<(const Sequence &s1, const Sequence &s2) {
+	unsigned int size = min<unsigned int>(s1._size, s2._size);
+	for (unsigned int i = 0; i < size; i++) {
+		char c1 = s1.getNucleotide(i), c2 = s2.getNucleotide(i);
+		if (c1 != c2) {
+			return (c1 < c2);
+		}
+	}
+	return (s1._size < s2._size);
 }
 
 ostream& operator<<(ostream& output, const Sequence& s) {
-	output << s._firstWord << "/" << s._secondWord;
+	output << s.getFirstWord() << "/" << s.getSecondWord();
 	return output;
 }
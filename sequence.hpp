@@ -17,16 +17,31 @@ along with this program.
 #define SEQUENCE_HPP 1
 
 #include <string>
+#include <vector>
 #include <iostream>
 #include <tuple>
+#include <cstdint>
 #include "globals.hpp"
 using namespace std;
 
+// A nucleotide sequence, with its reverse complement.
+// The nucleotides are packed on 2 bits, and the other characters (N, etc.)
+// are stored aside.  The reverse complement is not stored: a flag tells
+// which strand is the first (i.e. the lexicographically smallest) word.
+// Some room is kept on both sides, so that adding nucleotides at either end
+// does not move the sequence.  The strands are then compared again, which
+// usually stops at the first nucleotides, but scans the whole sequence for
+// a palindrome.
 class Sequence {
 
     private:
-		string _firstWord;
-		string _secondWord;
+		static constexpr unsigned int NUCLEOTIDES_PER_BLOCK = 32;
+
+		vector <uint64_t>              _codes;
+		vector <pair <unsigned int, char> > _others;
+		unsigned int                   _start;
+		unsigned int                   _size;
+		bool                           _reverse;
 
     public:
         Sequence ();
@@ -35,9 +50,11 @@ class Sequence {
 		const bool empty() const;
 		const unsigned int getSize () const;
 		const unsigned int getUnambiguousSize () const;
-		const string &getFirstWord ()  const;
-		const string &getSecondWord () const;
-		const string &getWord (const short i) const;
+		string getFirstWord ()  const;
+		string getSecondWord () const;
+		string getWord (const short i) const;
+		string getWord (const short i, const unsigned int start, const unsigned int size) const;
+		char getNucleotide (const unsigned int i, const short direction = Globals::DIRECT) const;
 		void setFirstWord (const string &word);
 		bool addFront (const string &nucleotides);
 		bool addBack  (const string &nucleotides);
@@ -49,15 +66,29 @@ class Sequence {
 
 		bool isAmbiguous () const;
 		bool isLowComplexity () const;
+		static bool isAmbiguous (const string &word);
+		static bool isLowComplexity (const string &word);
 
 		string printFasta(string name) const;
 
 		friend bool operator==(const Sequence &s1, const Sequence &s2);
+		friend bool operator<(const Sequence &s1, const Sequence &s2);
 		friend ostream& operator<<(ostream& output, const Sequence& s);
 
 
 	private:
-		bool computeSecondWord ();
+		char getChar (const unsigned int position) const;
+		uint64_t getBits (const unsigned int index) const;
+		void setBits (const unsigned int index, const uint64_t code);
+		void setChar (const unsigned int position, const char c, vector <pair <unsigned int, char> > &others);
+		void reserveFront (const unsigned int size);
+		void reserveBack (const unsigned int size);
+		void prepend (const string &nucleotides);
+		void append (const string &nucleotides);
+		void insert (const Sequence &k, const short direction, const unsigned int start, const unsigned int size, const short position);
+		bool add (const Sequence &k, const short direction, const unsigned int start, const unsigned int size, const short position);
+		bool matches (const unsigned int thisStart, const Sequence &k, const short direction, const unsigned int thatStart, const int size) const;
+		int compareStrands () const;
 };
 
 #endif
@@ -17,72 +17,170 @@ along with this program.
 #include <config.h>
 #endif
 
+#include <algorithm>
+#include <limits>
 #include "sequenceComparator.hpp"
 
+constexpr unsigned char SequenceComparator::DIAGONAL;
+constexpr unsigned char SequenceComparator::UP;
+constexpr unsigned char SequenceComparator::LEFT;
 
-SequenceComparator::SequenceComparator(): _noMatch(false) {
-	_table = new Penalty*[Globals::MAX_MERGE_SIZE+1];
-	for (int i = 0; i <= Globals::MAX_MERGE_SIZE; i++) {
-		_table[i] = new Penalty[Globals::MAX_MERGE_SIZE+1];
-	}
+SequenceComparator::SequenceComparator(): _noMatch(false) { }
+
+void SequenceComparator::compare (const string &s1, const string &s2) {
+	compare(s1, s2, -static_cast<int>(s2.size()), s1.size());
 }
 
-SequenceComparator::~SequenceComparator() {
-	for (int i = 0; i <= Globals::MAX_MERGE_SIZE; i++) {
-		delete[] _table[i];
+void SequenceComparator::compare (const string &s1, const string &s2, int minDiagonal, int maxDiagonal) {
+	_first       = s1;
+	_second      = s2;
+	_sizeFirst   = _first.size();
+	_sizeSecond  = _second.size();
+	_minDiagonal = minDiagonal;
+	_maxDiagonal = max<int>(maxDiagonal, minDiagonal + 1);
+	_noMatch     = false;
+	_reversed.assign(_second.rbegin(), _second.rend());
+	fillTable(_minDiagonal, _maxDiagonal, false);
+	findEnd();
+	if (_noMatch) {
+		return;
 	}
-	delete[] _table;
+	// An alignment of cost c has at most c / PENALTY_INDEL indels, so every
+	// optimal alignment ending in (_sizeFirst, _endSecond) stays that close to
+	// the diagonal of its end.
+	int width    = (Globals::PENALTY_INDEL > 0)? _lastRow[_endSecond] / Globals::PENALTY_INDEL: _sizeFirst + _sizeSecond;
+	int diagonal = _sizeFirst - _endSecond;
+	int low      = max<int>(_minDiagonal, diagonal - width);
+	fillTable(low, max<int>(min<int>(_maxDiagonal, diagonal + width), low + 1), true);
+	computeBackTrace();
 }
 
-void SequenceComparator::compare (const string &s1, const string &s2) {
-	_first      = s1;
-	_second     = s2;
-	_sizeFirst  = _first.size();
-	_sizeSecond = _second.size();
-	_noMatch    = false;
-	initTable();
-	fillTable();
-	computeBackTrace();
+// Rounding of the half of a possibly negative number
+static inline int floorHalf (int x) {
+	return (x >= 0)? x / 2: -((1 - x) / 2);
 }
 
-void SequenceComparator::initTable () {
-	int maxUnaligned = _sizeFirst - Globals::MIN_MERGE_SIZE;
-	for (int i = 0; i <= Globals::MAX_MERGE_SIZE; i++) {
-		_table[i][0] = (i < maxUnaligned)? i * Globals::PENALTY_SIZE: Globals::MAX_PENALTY;
-		_table[0][i] = i * Globals::PENALTY_INDEL;
-	}
+static inline int ceilHalf (int x) {
+	return -floorHalf(-x);
 }
 
-void SequenceComparator::fillTable () {
-	for (int i = 1; i <= _sizeFirst; i++) {
-		Penalty minValue = static_cast<Penalty>(-1);
-		for (int j = 1; j <= _sizeSecond; j++) {
-			Penalty value1 = _table[i-1][j-1] + ((_first[i-1] == _second[j-1])? 0: Globals::PENALTY_MISMATCH);
-			Penalty value2 = _table[i][j-1] + Globals::PENALTY_INDEL;
-			Penalty value3 = _table[i-1][j] + Globals::PENALTY_INDEL;
-			_table[i][j] = std::min<Penalty>(std::min<Penalty>(value1, value2), value3);
-			minValue = std::min<Penalty>(minValue, _table[i][j]);
+// The cell (i, j) is on the anti-diagonal i+j.  The first column costs
+// PENALTY_SIZE per unaligned nucleotide, and the first row PENALTY_INDEL.
+// The comparison stops as soon as a row (first column excluded) is above
+// MAX_PENALTY.
+// The cell (i, j) is on the diagonal i-j.  Only the cells of the band
+// minDiagonal...maxDiagonal are computed; the two cells surrounding the
+// band on an anti-diagonal are set to the maximum value, which is enough
+// for the next anti-diagonals, since the band moves by at most one cell.
+// The cells are signed (SSE2 only has a signed 16 bits minimum), and
+// saturate below 2^15.  Only the cells above MAX_PENALTY can saturate, so
+// the alignments below MAX_PENALTY are not changed.
+// Without keepDirections, the directions are written in a discarded
+// anti-diagonal.  Otherwise, they are kept for the cells of the band, up to
+// the end of the alignment, and the comparison never stops early.
+void SequenceComparator::fillTable (int minDiagonal, int maxDiagonal, bool keepDirections) {
+	int   maxUnaligned = _sizeFirst - Globals::MIN_MERGE_SIZE;
+	int   lastDiagonal = keepDirections? _sizeFirst + _endSecond: _sizeFirst + _sizeSecond;
+	short maxValue     = numeric_limits<short>::max() - max<Penalty>(Globals::PENALTY_MISMATCH, Globals::PENALTY_INDEL);
+	for (vector <short> &diagonal: _diagonals) {
+		diagonal.resize(_sizeFirst + 1);
+	}
+	_rowMins.assign(_sizeFirst + 1, maxValue);
+	_lastRow.resize(_sizeSecond + 1);
+	if (keepDirections) {
+		_directions.resize((lastDiagonal + 1) * ((maxDiagonal - minDiagonal) / 2 + 1));
+		_diagonalStarts.resize(lastDiagonal + 1);
+	}
+	else {
+		_discardedDirections.resize(_sizeFirst + 1);
+	}
+	short      *previous2 = _diagonals[0].data(), *previous = _diagonals[1].data(), *current = _diagonals[2].data();
+	short      *rowMins   = _rowMins.data();
+	const char *first     = _first.data(), *reversed = _reversed.data();
+	int         nbDirections = 0;
+	previous[0] = 0;
+	_lastRow[0] = 0;
+	for (int d = 1; d <= lastDiagonal; d++) {
+		int            low        = max<int>(0, d - _sizeSecond), high = min<int>(_sizeFirst, d);
+		int            start      = max<int>(1, low), end = min<int>(_sizeFirst, d - 1);
+		int            offset     = _sizeSecond - d;
+		int            bandLow    = ceilHalf(d + minDiagonal), bandHigh = floorHalf(d + maxDiagonal);
+		int            cellLow    = max<int>(start, bandLow), cellHigh = min<int>(end, bandHigh);
+		unsigned char *directions = _discardedDirections.data();
+		if (keepDirections) {
+			_diagonalStarts[d] = nbDirections - cellLow;
+			directions         = _directions.data() + _diagonalStarts[d];
+			nbDirections      += max<int>(0, cellHigh - cellLow + 1);
+		}
+		if (low == 0) {
+			current[0] = ((bandLow <= 0) && (bandHigh >= 0))? min<int>(d * Globals::PENALTY_INDEL, maxValue): maxValue;
+		}
+		if (high == d) {
+			current[d] = ((bandLow <= d) && (bandHigh >= d))? min<int>((d < maxUnaligned)? d * Globals::PENALTY_SIZE: Globals::MAX_PENALTY, maxValue): maxValue;
 		}
-		if (minValue >= Globals::MAX_PENALTY) {
+		fillDiagonal(first, reversed, offset, previous2, previous, current, rowMins, directions, cellLow, cellHigh, maxValue);
+		if ((bandLow - 1 >= low) && (bandLow - 1 <= high)) {
+			current[bandLow - 1] = maxValue;
+		}
+		if ((bandHigh + 1 >= low) && (bandHigh + 1 <= high)) {
+			current[bandHigh + 1] = maxValue;
+		}
+		if (high == _sizeFirst) {
+			_lastRow[d - _sizeFirst] = ((bandLow <= _sizeFirst) && (bandHigh >= _sizeFirst))? current[_sizeFirst]: maxValue;
+		}
+		// the rows which do not cross the band are not computed
+		int row = d - _sizeSecond;
+		if ((! keepDirections) && (row >= 1) && (row - 1 >= minDiagonal) && (row - _sizeSecond <= maxDiagonal) && (rowMins[row] >= Globals::MAX_PENALTY)) {
 			_noMatch = true;
 			return;
 		}
+		swap(previous2, previous);
+		swap(previous, current);
 	}
 }
 
-void SequenceComparator::computeBackTrace () {
+// Fill the cells start..end of an anti-diagonal, given the two previous
+// ones; the letter of the second sequence is reversed[offset+i].  The
+// arrays never overlap, which lets the loop be vectorized.
+void SequenceComparator::fillDiagonal (const char *__restrict__ first, const char *__restrict__ reversed, int offset, const short *__restrict__ previous2, const short *__restrict__ previous, short *__restrict__ current, short *__restrict__ rowMins, unsigned char *__restrict__ directions, int start, int end, short maxValue) {
+	short mismatch = Globals::PENALTY_MISMATCH, indel = Globals::PENALTY_INDEL;
+	for (int i = start; i <= end; i++) {
+		short diagonal = previous2[i-1] + ((first[i-1] == reversed[offset+i])? 0: mismatch);
+		short up       = previous[i-1] + indel;
+		short left     = previous[i] + indel;
+		short value    = std::min<short>(std::min<short>(std::min<short>(diagonal, left), up), maxValue);
+		current[i]     = value;
+		directions[i]  = (diagonal == value)? DIAGONAL: ((up == value)? UP: LEFT);
+		rowMins[i]     = std::min<short>(rowMins[i], value);
+	}
+}
+
+unsigned char SequenceComparator::getDirection (int i, int j) const {
+	return _directions[_diagonalStarts[i + j] + i];
+}
+
+// The best end of the overlap, on the last row.
+void SequenceComparator::findEnd () {
 	if (_noMatch) {
 		return;
 	}
 	Penalty minValue = static_cast<Penalty>(-1);
+	_endSecond       = -1;
 	for (int j = Globals::MIN_MERGE_SIZE + 1; j <= _sizeSecond; j++) {
-		Penalty value = _table[_sizeFirst][j] + (_sizeSecond - j) * Globals::PENALTY_SIZE;
+		Penalty value = _lastRow[j] + (_sizeSecond - j) * Globals::PENALTY_SIZE;
 		if (value < minValue) {
 			_endSecond = j;
 			minValue   = value;
 		}
 	}
+	if (_endSecond == -1) {
+		_noMatch = true;
+		return;
+	}
 	_score = minValue;
+}
+
+void SequenceComparator::computeBackTrace () {
 	int i = _sizeFirst, j = _endSecond;
 	int alignmentSize = 0, identity = 0;
 	while ((i > _sizeFirst - Globals::MIN_MERGE_SIZE) || (j > 0)) {
@@ -92,33 +190,21 @@ void SequenceComparator::computeBackTrace () {
 		else if (j == 0) {
 			i--;
 		}
-		else if (_table[i][j] == _table[i-1][j-1] + ((_first[i-1] == _second[j-1])? 0: Globals::PENALTY_MISMATCH)) {
-			i--; j--;
-			alignmentSize++;
-			if (_first[i] == _second[j]) {
-				identity++;
-			}
-		}
-		else if (_table[i][j] == _table[i-1][j] + Globals::PENALTY_INDEL) {
-			i--;
-		}
-		else if (_table[i][j] == _table[i][j-1] + Globals::PENALTY_INDEL) {
-			j--;
-		}
 		else {
-			cerr << "Problem in backtrace in (" << i << ", " << j << ") of table (" << _first.size() << ", " << _second.size() << "): table[" << i << "][" << j << "] = " << _table[i][j];
-			if (i > 0) {
-				cerr << " table[" << i-1 << "][" << j << "] = " << _table[i-1][j];
+			unsigned char direction = getDirection(i, j);
+			if (direction == DIAGONAL) {
+				i--; j--;
+				alignmentSize++;
+				if (_first[i] == _second[j]) {
+					identity++;
+				}
 			}
-			if (j > 0) {
-				cerr << " table[" << i << "][" << j-1 << "] = " << _table[i][j-1];
+			else if (direction == UP) {
+				i--;
 			}
-			if ((i > 0) && (j > 0)) {
-				cerr << " table[" << i-1 << "][" << j-1 << "] = " << _table[i-1][j-1] << ", seq1[" << (i-1) << "] = '" << _first[i-1] << "',  seq2[" << (j-1) << "] = '" << _second[j-1] << "'";
+			else {
+				j--;
 			}
-			cerr << endl;
-			cerr << "Matrix is:" << endl;
-			cerr << *this << endl;
 		}
 	}
 	_startFirst = i;
@@ -145,20 +231,7 @@ int SequenceComparator::getEndSecond () const {
 }
 
 ostream& operator<<(ostream& output, const SequenceComparator& sq) {
-	output << "\t";
-	for (unsigned int i = 0; i < sq._first.size(); i++) {
-		output << "\t" << sq._first[i];
-	}
-	output << endl;
-	for (int j = 0; j <= sq._sizeSecond; j++) {
-		if (j > 0)  {
-			output << sq._second[j-1];
-		}
-		for (int i = 0; i <= sq._sizeFirst; i++) {
-			output << "\t" << sq._table[i][j];
-		}
-		output << endl;
-	}
+	output << sq._first << "\n" << sq._second << "\n";
 	if (sq._noMatch) {
 		output << "no match";
 	}
@@ -167,4 +240,3 @@ ostream& operator<<(ostream& output, const SequenceComparator& sq) {
 	}
 	return output;
 }
-
@@ -17,27 +17,46 @@ along with this program.
 #define SEQUENCE_COMPARATOR_HPP 1
 
 #include <string>
+#include <vector>
 #include <iostream>
 #include "globals.hpp"
 using namespace std;
 
 
+// Overlap alignment of the end of the first sequence with the start of the
+// second one.  The table is filled by anti-diagonals: the cells of an
+// anti-diagonal only depend on the two previous ones, so the inner loop has
+// no dependency, and is vectorized on 16 bits.  Only the three last
+// anti-diagonals are kept.  The table is filled a second time to store the
+// directions of the backtrace (one byte per cell), but only in a narrow band
+// around the best end, which contains every optimal alignment.
+// The comparison can be restricted to a band of diagonals (i-j, where i is
+// in the first sequence), when the offset of the overlap is known.
 class SequenceComparator {
 
     private:
-		//Penalty _table[Globals::MAX_MERGE_SIZE+1][Globals::MAX_MERGE_SIZE+1];
-		Penalty **_table;
+		static constexpr unsigned char DIAGONAL = 0;
+		static constexpr unsigned char UP       = 1;
+		static constexpr unsigned char LEFT     = 2;
+
 		bool    _noMatch;
-		string  _first, _second;
+		string  _first, _second, _reversed;
 		int     _sizeFirst, _sizeSecond;
 		int     _startFirst, _endSecond;
+		int     _minDiagonal, _maxDiagonal;
 		Penalty _score;
 		float   _identity;
+		vector <short>         _diagonals[3];
+		vector <short>         _rowMins;
+		vector <short>         _lastRow;
+		vector <unsigned char> _directions;
+		vector <unsigned char> _discardedDirections;
+		vector <int>           _diagonalStarts;
 
     public:
         SequenceComparator ();
-        ~SequenceComparator ();
 		void compare (const string &s1, const string &s2);
+		void compare (const string &s1, const string &s2, int minDiagonal, int maxDiagonal);
 		Penalty getBestScore () const;
 		float getIdentity () const;
 		int getStartFirst () const;
@@ -46,9 +65,11 @@ class SequenceComparator {
 		friend ostream& operator<<(ostream& output, const SequenceComparator& sq);
 
 	private:
-		void initTable ();
-		void fillTable ();
+		void fillTable (int minDiagonal, int maxDiagonal, bool keepDirections);
+		void findEnd ();
+		static void fillDiagonal (const char *__restrict__ first, const char *__restrict__ reversed, int offset, const short *__restrict__ previous2, const short *__restrict__ previous, short *__restrict__ current, short *__restrict__ rowMins, unsigned char *__restrict__ directions, int start, int end, short maxValue);
 		void computeBackTrace ();
+		unsigned char getDirection (int i, int j) const;
 
 };
 
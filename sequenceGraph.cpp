@@ -19,70 +19,65 @@ along with this program.
 
 #include "globals.hpp"
 #include "sequenceGraph.hpp"
+#include "pathSpeller.hpp"
 #include <thread>
 #include <stack>
 #include <map>
 
-SequenceNode::SequenceNode (unsigned int id, KmerNb count): _id(id), _count(count), _set(true), _marked(false), _direct(true) {}
-
-SequenceNode::SequenceNode (unsigned int id, KmerNb count, const Sequence &sequence): _id(id), _count(count), _sequence(sequence), _set(true), _marked(false), _direct(true) {}
-
-void SequenceNode::addNeighbor(unsigned int id, short position, short direction) {
-	if (find(_neighbors[position][direction].begin(), _neighbors[position][direction].end(), id) == _neighbors[position][direction].end()) {
-		_neighbors[position][direction].push_back(id);
-	}
-}
-
-void SequenceNode::setId(unsigned int id) {
-	_id = id;
-}
+SequenceNode::SequenceNode (SequenceGraph *graph, unsigned int id): _graph(graph), _id(id) {}
 
 unsigned int SequenceNode::getId() const {
 	return _id;
 }
 
 unsigned int SequenceNode::getSize() const {
-	return _sequence.getSize();
+	return _graph->_sequences[_id].getSize();
+}
+
+// The nodes of the merger and of the scaffolder are repeats, which may be
+// shorter than a k-mer: they count for one k-mer.
+unsigned int SequenceNode::getNbKmers() const {
+	return (getSize() >= Globals::KMER)? getSize() - Globals::KMER + 1: 1;
 }
 
 const Sequence &SequenceNode::getSequence() const {
-	return _sequence;
+	return _graph->_sequences[_id];
 }
 
 void SequenceNode::setSequence(const Sequence sequence) {
-	_sequence = sequence;
+	_graph->_sequences[_id] = sequence;
 }
 
 KmerNb SequenceNode::getCount() const {
-	return _count;
+	return _graph->_counts[_id];
 }
 
 void SequenceNode::unset() {
-	_set = false;
+	_graph->_flags[_id] &= ~SequenceGraph::NODE_SET;
 }
 
 bool SequenceNode::isSet() const {
-	return _set;
+	return (_graph->_flags[_id] & SequenceGraph::NODE_SET);
 }
 
 void SequenceNode::mark() {
-	_marked = true;
+	_graph->_flags[_id] |= SequenceGraph::NODE_MARKED;
 }
 
 bool SequenceNode::isMarked() const {
-	return _marked;
+	return (_graph->_flags[_id] & SequenceGraph::NODE_MARKED);
 }
 
 bool SequenceNode::isDirect() const {
-	return _direct;
+	return (_graph->_flags[_id] & SequenceGraph::NODE_DIRECT);
 }
 
 bool SequenceNode::isLeaf() const {
-	return (((_neighbors[Globals::BEFORE][Globals::DIRECT].empty()) && (_neighbors[Globals::BEFORE][Globals::REVERSE].empty())) || ((_neighbors[Globals::AFTER][Globals::DIRECT].empty()) && (_neighbors[Globals::AFTER][Globals::REVERSE].empty())));
+	return (((getNbNeighbors(Globals::BEFORE, Globals::DIRECT) == 0) && (getNbNeighbors(Globals::BEFORE, Globals::REVERSE) == 0)) || ((getNbNeighbors(Globals::AFTER, Globals::DIRECT) == 0) && (getNbNeighbors(Globals::AFTER, Globals::REVERSE) == 0)));
 }
 
 short SequenceNode::getOnlyDirection() const {
-	if ((! _neighbors[Globals::BEFORE][Globals::DIRECT].empty()) || (! _neighbors[Globals::BEFORE][Globals::REVERSE].empty())) {
+	if ((getNbNeighbors(Globals::BEFORE, Globals::DIRECT) != 0) || (getNbNeighbors(Globals::BEFORE, Globals::REVERSE) != 0)) {
 		return Globals::BEFORE;
 	}
 	else {
@@ -91,23 +86,25 @@ short SequenceNode::getOnlyDirection() const {
 }
 
 int SequenceNode::getNbNeighbors(short position, short direction) const {
-	return _neighbors[position][direction].size();
+	return _graph->getNbNeighbors(_id, position, direction);
 }
 
 const unsigned int SequenceNode::getNeighbor(short position, short direction, int i) const {
-	return _neighbors[position][direction][i];
+	return _graph->getNeighbor(_id, position, direction, i);
 }
 
 bool SequenceNode::merge(short position, short direction, const SequenceNode &n) {
+	SequenceGraph::Links &links = _graph->getLinks(_id);
 	for (short d = 0; d < Globals::DIRECTIONS; d++) {
-		//_neighbors[position][d] = n._neighbors[(direction == Globals::DIRECT)? position: 1-position][(direction == Globals::DIRECT)? d: 1-d];
-		const vector <unsigned int> &neighbors = n._neighbors[(direction == Globals::DIRECT)? position: 1-position][(direction == Globals::DIRECT)? d: 1-d];
-		_neighbors[position][d].assign(neighbors.begin(), neighbors.end());
+		short otherPosition  = (direction == Globals::DIRECT)? position: 1-position;
+		short otherDirection = (direction == Globals::DIRECT)? d: 1-d;
+		_graph->copyLinks(n._id, otherPosition * Globals::DIRECTIONS + otherDirection, links[position * Globals::DIRECTIONS + d]);
 	}
-	_count = (getCount() * getSize() + n.getCount() * n.getSize()) / (getSize() + n.getSize());
-	string thisString = (_direct)? _sequence.getWord(Globals::DIRECT): _sequence.getWord(Globals::REVERSE);
+	_graph->_counts[_id] = (getCount() * getSize() + n.getCount() * n.getSize()) / (getSize() + n.getSize());
+	const Sequence &thisSequence = getSequence(), &thatSequence = n.getSequence();
+	string thisString = (isDirect())? thisSequence.getWord(Globals::DIRECT): thisSequence.getWord(Globals::REVERSE);
 	//string thatString = (_direct == (direction == Globals::DIRECT))? n._sequence.getWord(Globals::DIRECT): n._sequence.getWord(Globals::REVERSE);
-	string thatString = ((n._direct) == (direction == Globals::DIRECT))? n._sequence.getWord(Globals::DIRECT): n._sequence.getWord(Globals::REVERSE);
+	string thatString = ((n.isDirect()) == (direction == Globals::DIRECT))? thatSequence.getWord(Globals::DIRECT): thatSequence.getWord(Globals::REVERSE);
 	string firstString, secondString;
 	if (position == Globals::AFTER) {
 		firstString = thisString;
@@ -119,9 +116,14 @@ bool SequenceNode::merge(short position, short direction, const SequenceNode &n)
 	}
 	secondString = secondString.substr(Globals::KMER-1);
 	string sequence = firstString + secondString;
-	_sequence = Sequence(sequence);
+	setSequence(Sequence(sequence));
 	//cout << "\t\tChecking reverse: " << _sequence.getFirstWord() << " vs " << sequence << endl;
-	_direct = (_sequence.getFirstWord() == sequence);
+	if (getSequence().getFirstWord() == sequence) {
+		_graph->_flags[_id] |= SequenceGraph::NODE_DIRECT;
+	}
+	else {
+		_graph->_flags[_id] &= ~SequenceGraph::NODE_DIRECT;
+	}
 	/*
 	if (_sequence.getFirstWord() != sequence) {
 		_direct = ! _direct;
@@ -132,15 +134,17 @@ bool SequenceNode::merge(short position, short direction, const SequenceNode &n)
 }
 
 void SequenceNode::updateLinks(unsigned int oldId, unsigned int newId, bool direct) {
+	SequenceGraph::Links &links = _graph->getLinks(_id);
 	for (short p = 0; p < Globals::POSITIONS; p++) {
 		for (short d = 0; d < Globals::DIRECTIONS; d++) {
-			for (unsigned int n = 0; n < _neighbors[p][d].size(); n++) {
-				if (_neighbors[p][d][n] == oldId) {
+			ArenaVector <unsigned int> &neighbors = links[p * Globals::DIRECTIONS + d];
+			for (unsigned int n = 0; n < neighbors.size(); n++) {
+				if (neighbors[n] == oldId) {
 					if (direct) {
-						_neighbors[p][d][n] = newId;
+						neighbors[n] = newId;
 					}
 					else {
-						_neighbors[p][1-d].push_back(newId);
+						links[p * Globals::DIRECTIONS + 1-d].push_back(newId);
 					}
 				}
 			}
@@ -149,12 +153,13 @@ void SequenceNode::updateLinks(unsigned int oldId, unsigned int newId, bool dire
 }
 
 void SequenceNode::removeLinks(short position, short direction) {
+	SequenceGraph::Links &links = _graph->getLinks(_id);
 	if (direction == Globals::DIRECTIONS) {
-		_neighbors[position][Globals::DIRECT].clear();
-		_neighbors[position][Globals::REVERSE].clear();
+		links[position * Globals::DIRECTIONS + Globals::DIRECT].clear();
+		links[position * Globals::DIRECTIONS + Globals::REVERSE].clear();
 	}
 	else {
-		_neighbors[position][direction].clear();
+		links[position * Globals::DIRECTIONS + direction].clear();
 	}
 }
 
@@ -163,65 +168,82 @@ bool operator==(const SequenceNode& n1, const SequenceNode& n2) {
 }
 
 ostream& operator<<(ostream& output, const SequenceNode& n) {
-	if (! n._neighbors[Globals::BEFORE][Globals::DIRECT].empty()) {
-		output << "(+) ";
-		for (const int neighbor: n._neighbors[Globals::BEFORE][Globals::DIRECT]) {
-			output << neighbor << " ";
-		}
-	}
-	if (! n._neighbors[Globals::BEFORE][Globals::REVERSE].empty()) {
-		output << "(-) ";
-		for (const int neighbor: n._neighbors[Globals::BEFORE][Globals::REVERSE]) {
-			output << neighbor << " ";
+	for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
+		if (n.getNbNeighbors(Globals::BEFORE, direction) > 0) {
+			output << ((direction == Globals::DIRECT)? "(+) ": "(-) ");
+			for (int i = 0; i < n.getNbNeighbors(Globals::BEFORE, direction); i++) {
+				output << n.getNeighbor(Globals::BEFORE, direction, i) << " ";
+			}
 		}
 	}
-	output << "<-- (" << n._id << ", " << n._sequence << ", " << n._count << ")";
-	if (! n._direct) {
+	output << "<-- (" << n._id << ", " << n.getSequence() << ", " << n.getCount() << ")";
+	if (! n.isDirect()) {
 		output << " (-)";
 	}
 	output << " --> ";
-	if (! n._neighbors[Globals::AFTER][Globals::DIRECT].empty()) {
-		output << "(+) ";
-		for (const int neighbor: n._neighbors[Globals::AFTER][Globals::DIRECT]) {
-			output << neighbor << " ";
-		}
-	}
-	if (! n._neighbors[Globals::AFTER][Globals::REVERSE].empty()) {
-		output << "(-) ";
-		for (const int neighbor: n._neighbors[Globals::AFTER][Globals::REVERSE]) {
-			output << neighbor << " ";
+	for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
+		if (n.getNbNeighbors(Globals::AFTER, direction) > 0) {
+			output << ((direction == Globals::DIRECT)? "(+) ": "(-) ");
+			for (int i = 0; i < n.getNbNeighbors(Globals::AFTER, direction); i++) {
+				output << n.getNeighbor(Globals::AFTER, direction, i) << " ";
+			}
 		}
 	}
 	return output;
 }
 
 
-SequencePath::SequencePath (): _cycle(false), _count(-1) {}
+SequencePath::SequencePath (): _hash(0), _cycle(false), _count(-1) {}
 
-SequencePath::SequencePath (const SequencePath &p): _nodes(p._nodes), _nodeIds(p._nodeIds), _cycle(p._cycle), _count(p._count)  {}
+SequencePath::SequencePath (const SequencePath &p): _nodes(p._nodes), _nodeIds(p._nodeIds), _hash(p._hash), _cycle(p._cycle), _count(p._count)  {}
 
-SequencePath::SequencePath (unsigned int id): _cycle(false), _count(-1) {
+SequencePath::SequencePath (unsigned int id): _hash(0), _cycle(false), _count(-1) {
 	addNode(id);
 }
 
-SequencePath::SequencePath(unsigned int id1, short position, short direction, unsigned int id2): _cycle(false), _count(-1) {
+SequencePath::SequencePath(unsigned int id1, short position, short direction, unsigned int id2): _hash(0), _cycle(false), _count(-1) {
 	addNode(id1);
 	addNode(position, direction, id2);
 }
 
+// The node ids are kept sorted, and their hash is the sum of the hashes of
+// the ids, so that it does not depend on the order of the nodes.
+static inline size_t hashNodeId(unsigned int id) {
+	uint64_t h = id + 0x9e3779b97f4a7c15ull;
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+	return static_cast<size_t>(h ^ (h >> 31));
+}
+
+void SequencePath::insertNodeId(unsigned int id) {
+	auto it = lower_bound(_nodeIds.begin(), _nodeIds.end(), id);
+	if ((it == _nodeIds.end()) || (*it != id)) {
+		_nodeIds.insert(it, id);
+		_hash += hashNodeId(id);
+	}
+}
+
+void SequencePath::eraseNodeId(unsigned int id) {
+	auto it = lower_bound(_nodeIds.begin(), _nodeIds.end(), id);
+	if ((it != _nodeIds.end()) && (*it == id)) {
+		_nodeIds.erase(it);
+		_hash -= hashNodeId(id);
+	}
+}
+
 void SequencePath::addNode(unsigned int id) {
 	addNode(-1, -1, id);
 }
 
 void SequencePath::addNode(short position, short direction, unsigned int id) {
 	_nodes.push_back(make_tuple(position, direction, id));
-	_nodeIds.insert(id);
+	insertNodeId(id);
 }
 
 void SequencePath::removeLastNode() {
 	int id = SequencePath::getLastNode();
 	_nodes.pop_back();
-	_nodeIds.erase(id);
+	eraseNodeId(id);
 }
 
 unsigned int SequencePath::getSize() const {
@@ -251,11 +273,12 @@ bool SequencePath::empty() const {
 void SequencePath::clear() {
 	_nodes.clear();
 	_nodeIds.clear();
+	_hash = 0;
 }
 
 void SequencePath::reverse() {
 	int size = _nodes.size();
-	vector < tuple <short, short, unsigned int> > nodes(size);
+	ArenaVector < tuple <short, short, unsigned int> > nodes(size);
 	for (int i = 0; i < size; i++) {
 		nodes[i] = make_tuple(-1, -1, get<2>(_nodes[size-1-i]));
 	}
@@ -282,22 +305,28 @@ KmerNb SequencePath::getCount() const {
 	return _count;
 }
 
+size_t SequencePath::getHash() const {
+	return _hash ^ hashNodeId((_nodes.size() << 1) | (_cycle? 1: 0));
+}
+
 bool SequencePath::contains(int id) const {
-	return (_nodeIds.find(id) != _nodeIds.end());
+	return binary_search(_nodeIds.begin(), _nodeIds.end(), static_cast<unsigned int>(id));
 }
 
 bool SequencePath::contains(const SequencePath &p) const {
-	for (int node: p._nodeIds) {
-		if (! contains(node)) {
-			return false;
-		}
-	}
-	return true;
+	return includes(_nodeIds.begin(), _nodeIds.end(), p._nodeIds.begin(), p._nodeIds.end());
 }
 
 bool SequencePath::crosses(const SequencePath &p) const {
-	for (int node: p._nodeIds) {
-		if (contains(node)) {
+	auto it1 = _nodeIds.begin(), it2 = p._nodeIds.begin();
+	while ((it1 != _nodeIds.end()) && (it2 != p._nodeIds.end())) {
+		if (*it1 < *it2) {
+			++it1;
+		}
+		else if (*it2 < *it1) {
+			++it2;
+		}
+		else {
 			return true;
 		}
 	}
@@ -319,19 +348,20 @@ bool SequencePath::crossesInterior(const SequencePath &p) const {
 }
 
 void SequencePath::trimTo(const unsigned int destination) {
-	vector < tuple <short, short, unsigned int> > nodes;
+	ArenaVector < tuple <short, short, unsigned int> > nodes;
 	short direct = true;
 	unsigned int pos;
 	_nodeIds.clear();
+	_hash = 0;
 	for (pos = 0; getNode(pos) != destination; pos++) {
 		if (getNodeDirection(pos) != Globals::DIRECT) {
 			direct = ! direct;
 		}
 	}
 	nodes.push_back(make_tuple(0, 0, destination));
-	_nodeIds.insert(destination);
+	insertNodeId(destination);
 	for (pos++; pos < _nodes.size(); pos++) {
-		_nodeIds.insert(getNode(pos));
+		insertNodeId(getNode(pos));
 		nodes.push_back(_nodes[pos]);
 	}
 	_nodes = nodes;
@@ -411,7 +441,7 @@ vector < SequencePath > SequencePath::addNode(const SequenceNode &linkNode, cons
 					direction = Globals::REVERSE;
 				}
 				for (int i = 0; i < newNode.getNbNeighbors(position, direction); i++) {
-					if (newNode.getNeighbor(position, direction, i) == linkNode) {
+					if (newNode.getNeighbor(position, direction, i) == linkNodeId) {
 						SequencePath newPath(newNodeId);
 						newPath.addNode(position, direction, linkNodeId);
 						for (unsigned int j = 1; j < getSize(); j++) {
@@ -459,7 +489,7 @@ SequencePath SequencePath::merge(const SequenceNode &linkNode, const SequencePat
 		}
 	}
 	for (unsigned int nodeId: path._nodeIds) {
-		if ((nodeId != linkNodeId) && (_nodeIds.find(nodeId) != _nodeIds.end())) {
+		if ((nodeId != linkNodeId) && (contains(nodeId))) {
 			return pOut;
 		}
 	}
@@ -545,7 +575,10 @@ bool operator==(const SequencePath& p1, const SequencePath& p2) {
 	if (p1._nodes.size() != p2._nodes.size()) {
 		return false;
 	}
-	return equal(p1._nodeIds.begin(), p1._nodeIds.end(), p2._nodeIds.begin());
+	if (p1._hash != p2._hash) {
+		return false;
+	}
+	return (p1._nodeIds == p2._nodeIds);
 }
 
 ostream& operator<<(ostream& output, const SequencePath& p) {
@@ -577,26 +610,32 @@ ostream& operator<<(ostream& output, const SequencePath& p) {
 }
 
 
+constexpr unsigned int  SequenceGraph::NB_SIDES;
+constexpr unsigned char SequenceGraph::NODE_SET;
+constexpr unsigned char SequenceGraph::NODE_MARKED;
+constexpr unsigned char SequenceGraph::NODE_DIRECT;
+
 SequenceGraph::SequenceGraph (): _maxPaths(0) {}
 
-SequenceGraph::SequenceGraph (int size): _maxPaths(0), _nodes(size) {}
+SequenceGraph::SequenceGraph (int size): _maxPaths(0), _counts(size, 0), _sequences(size), _flags(size, NODE_SET | NODE_DIRECT) {}
 
 void SequenceGraph::setMaxPaths(const unsigned int maxPaths) {
 	_maxPaths = maxPaths;
 }
 
 unsigned int SequenceGraph::getSize() const {
-	return _nodes.size();
+	return _counts.size();
 }
 
 bool SequenceGraph::isSmall () const {
 	int size = Globals::KMER-1;
-	for (const SequenceNode &node: _nodes) {
+	for (unsigned int i = 0; i < getSize(); i++) {
+		const SequenceNode node = getNode(i);
 		//cout << "Size of node " << node << " is " << node.getSize() << endl;
 		if (node.isSet()) {
 			//cout << "\tis set" << endl;
 			//size += node.getSize();
-			size++;
+			size += node.getSize() - Globals::KMER + 1;
 		}
 	}
 	//cout << "Total size is " << size << ", threshold is " << Globals::MIN_NB_NODES << endl;
@@ -604,29 +643,35 @@ bool SequenceGraph::isSmall () const {
 }
 
 bool SequenceGraph::isBig () const {
-	return (_nodes.size() > Globals::MAX_NB_NODES);
+	unsigned int size = 0;
+	for (unsigned int i = 0; i < getSize(); i++) {
+		const SequenceNode node = getNode(i);
+		if (node.isSet()) {
+			size += node.getSize() - Globals::KMER + 1;
+		}
+	}
+	return (size > Globals::MAX_NB_NODES);
 }
 
 void SequenceGraph::addNode(unsigned int id, KmerNb count) {
-	if (id < _nodes.size()) {
-		_nodes[id] = SequenceNode(id, count);
-	}
-	else if (id == _nodes.size()) {
-		_nodes.push_back(SequenceNode(id, count));
-	}
-	else {
-		cerr << "Error while inserting the node " << id << endl;
-	}
+	addNode(id, count, Sequence());
 }
 
 void SequenceGraph::addNode(unsigned int id, KmerNb count, const Sequence &sequence) {
-	if (id < _nodes.size()) {
-		//cout << "adding node " << id << "/" << _nodes.size() << " mode 1" << endl;
-		_nodes[id] = SequenceNode(id, count, sequence);
+	if (id < getSize()) {
+		//cout << "adding node " << id << "/" << getSize() << " mode 1" << endl;
+		_counts[id]    = count;
+		_sequences[id] = sequence;
+		_flags[id]     = NODE_SET | NODE_DIRECT;
+		for (ArenaVector <unsigned int> &links: getLinks(id)) {
+			links.clear();
+		}
 	}
-	else if (id == _nodes.size()) {
-		//cout << "adding node " << id << "/" << _nodes.size() << " mode 2" << endl;
-		_nodes.push_back(SequenceNode(id, count, sequence));
+	else if (id == getSize()) {
+		//cout << "adding node " << id << "/" << getSize() << " mode 2" << endl;
+		_counts.push_back(count);
+		_sequences.push_back(sequence);
+		_flags.push_back(NODE_SET | NODE_DIRECT);
 	}
 	else {
 		cerr << "Error while inserting the node " << id << endl;
@@ -634,17 +679,104 @@ void SequenceGraph::addNode(unsigned int id, KmerNb count, const Sequence &seque
 }
 
 void SequenceGraph::addLink (unsigned int n1, short pos1, short dir1, unsigned int n2) {
-	_nodes[n1].addNeighbor(n2, pos1, dir1);
 	short dir2 = dir1;
 	short pos2 = (dir1 == Globals::DIRECT)? 1-pos1: pos1;
-	_nodes[n2].addNeighbor(n1, pos2, dir2);
+	_newLinks.push_back(make_pair(n1 * NB_SIDES + pos1 * Globals::DIRECTIONS + dir1, n2));
+	_newLinks.push_back(make_pair(n2 * NB_SIDES + pos2 * Globals::DIRECTIONS + dir2, n1));
+}
+
+SequenceNode SequenceGraph::getNode (const unsigned int i) {
+	return SequenceNode(this, i);
+}
+
+const SequenceNode SequenceGraph::getNode (const unsigned int i) const {
+	return SequenceNode(const_cast<SequenceGraph *>(this), i);
+}
+
+unsigned int SequenceGraph::getNbNeighbors (const unsigned int i, const short position, const short direction) const {
+	unsigned int side = position * Globals::DIRECTIONS + direction;
+	if (! _overlay.empty()) {
+		auto it = _overlay.find(i);
+		if (it != _overlay.end()) {
+			return it->second[side].size();
+		}
+	}
+	if (i * NB_SIDES + side + 1 >= _offsets.size()) {
+		return 0;
+	}
+	return _offsets[i * NB_SIDES + side + 1] - _offsets[i * NB_SIDES + side];
+}
+
+unsigned int SequenceGraph::getNeighbor (const unsigned int i, const short position, const short direction, const unsigned int n) const {
+	unsigned int side = position * Globals::DIRECTIONS + direction;
+	if (! _overlay.empty()) {
+		auto it = _overlay.find(i);
+		if (it != _overlay.end()) {
+			return it->second[side][n];
+		}
+	}
+	return _links[_offsets[i * NB_SIDES + side] + n];
+}
+
+void SequenceGraph::copyLinks (const unsigned int i, const short side, ArenaVector <unsigned int> &links) const {
+	auto it = _overlay.find(i);
+	if (it != _overlay.end()) {
+		links = it->second[side];
+	}
+	else if (i * NB_SIDES + side + 1 < _offsets.size()) {
+		links.assign(_links.begin() + _offsets[i * NB_SIDES + side], _links.begin() + _offsets[i * NB_SIDES + side + 1]);
+	}
+	else {
+		links.clear();
+	}
 }
 
-SequenceNode &SequenceGraph::getNode (const unsigned int i) {
-	return _nodes[i];
+// The links of a node are copied to the overlay before being changed.
+SequenceGraph::Links &SequenceGraph::getLinks (const unsigned int i) {
+	auto it = _overlay.find(i);
+	if (it != _overlay.end()) {
+		return it->second;
+	}
+	Links links;
+	for (unsigned int side = 0; side < NB_SIDES; side++) {
+		copyLinks(i, side, links[side]);
+	}
+	return _overlay.emplace(i, move(links)).first->second;
+}
+
+// Rebuilds the layout with the links of the overlay, and the new links, in
+// the order they have been added.  Duplicated new links are discarded.
+void SequenceGraph::freeze () {
+	if ((_overlay.empty()) && (_newLinks.empty()) && (_offsets.size() == getSize() * NB_SIDES + 1)) {
+		return;
+	}
+	unsigned int               nbSlots = getSize() * NB_SIDES;
+	unsigned int               next    = 0;
+	ArenaVector <unsigned int> offsets(nbSlots + 1);
+	ArenaVector <unsigned int> links;
+	ArenaVector <unsigned int> slotLinks;
+	links.reserve(_links.size() + _newLinks.size());
+	stable_sort(_newLinks.begin(), _newLinks.end(), [](const pair <unsigned int, unsigned int> &l1, const pair <unsigned int, unsigned int> &l2) { return l1.first < l2.first; });
+	for (unsigned int slot = 0; slot < nbSlots; slot++) {
+		unsigned int start = links.size();
+		offsets[slot] = start;
+		copyLinks(slot / NB_SIDES, slot % NB_SIDES, slotLinks);
+		links.insert(links.end(), slotLinks.begin(), slotLinks.end());
+		for (; (next < _newLinks.size()) && (_newLinks[next].first == slot); next++) {
+			if (find(links.begin() + start, links.end(), _newLinks[next].second) == links.end()) {
+				links.push_back(_newLinks[next].second);
+			}
+		}
+	}
+	offsets[nbSlots] = links.size();
+	_offsets.swap(offsets);
+	_links.swap(links);
+	_overlay.clear();
+	_newLinks.clear();
 }
 
 bool SequenceGraph::findAllPathes() {
+	freeze();
 	//findLeaves();
 	return findPathes();
 	//findCycles();
@@ -653,8 +785,12 @@ bool SequenceGraph::findAllPathes() {
 bool SequenceGraph::findPathes() {
 	//cout << "Starting path finding with graph\n" << *this << endl;
 	map < unsigned int, vector < unsigned int > > pathEnds;
+	_pathHashes.clear();
+	for (unsigned int pathId = 0; pathId < _pathes.size(); pathId++) {
+		_pathHashes.insert(make_pair(_pathes[pathId].getHash(), pathId));
+	}
 	for (unsigned int nodeId = 0; nodeId < getSize(); nodeId++) {
-		SequenceNode &node = _nodes[nodeId];
+		SequenceNode node = getNode(nodeId);
 		if (node.isSet()) {
 			//cout << "\tNow node " << node << endl;
 			unsigned int start = _pathes.size();
@@ -662,7 +798,7 @@ bool SequenceGraph::findPathes() {
 				for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
 					for (int i = 0; i < node.getNbNeighbors(position, direction); i++) {
 						unsigned int neighborId = node.getNeighbor(position, direction, i);
-						SequenceNode &neighbor = _nodes[neighborId];
+						SequenceNode neighbor = getNode(neighborId);
 						if (neighbor.isSet()) {
 							//cout << "\t\tNow neighbor " << neighbor << endl;
 							unsigned int peEnd = pathEnds[neighborId].size();
@@ -676,9 +812,9 @@ bool SequenceGraph::findPathes() {
 											pathEnds[newPath.getNode(0)].push_back(_pathes.size());
 											pathEnds[newPath.getLastNode()].push_back(_pathes.size());
 										}
-										_pathes.push_back(newPath);
+										addPath(newPath);
 										if ((_maxPaths > 0) && (_pathes.size() > _maxPaths)) {
-											_pathes.clear();
+											clearPathes();
 											findGreedyPathes();
 											return false;
 										}
@@ -701,7 +837,7 @@ bool SequenceGraph::findPathes() {
 					short p      = (dEnd == Globals::DIRECT)? pEnd: 1-pEnd;
 					short d      = Globals::DIRECT;
 					bool found   = false;
-					SequenceNode &lastNode   = _nodes[path.getNode(last)];
+					SequenceNode lastNode    = getNode(path.getNode(last));
 					unsigned int firstNodeId = path.getNode(0);
 					if (p != pStart) {
 						d = Globals::REVERSE;
@@ -717,9 +853,9 @@ bool SequenceGraph::findPathes() {
 						newPath.setCycle();
 						if (checkPath(newPath)) {
 							//cout << "\t\t\tGot new path " << newPath << endl;
-							_pathes.push_back(newPath);
+							addPath(newPath);
 							if ((_maxPaths > 0) && (_pathes.size() > _maxPaths)) {
-								_pathes.clear();
+								clearPathes();
 								findGreedyPathes();
 								return false;
 							}
@@ -740,9 +876,9 @@ bool SequenceGraph::findPathes() {
 									pathEnds[newPath.getNode(0)].push_back(_pathes.size());
 									pathEnds[newPath.getLastNode()].push_back(_pathes.size());
 								}
-								_pathes.push_back(newPath);
+								addPath(newPath);
 								if ((_maxPaths > 0) && (_pathes.size() > _maxPaths)) {
-									_pathes.clear();
+									clearPathes();
 									findGreedyPathes();
 									return false;
 								}
@@ -752,9 +888,9 @@ bool SequenceGraph::findPathes() {
 				}
 			}
 			pathEnds[nodeId].push_back(_pathes.size());
-			_pathes.push_back(SequencePath(nodeId));
+			addPath(SequencePath(nodeId));
 			if ((_maxPaths > 0) && (_pathes.size() > _maxPaths)) {
-				_pathes.clear();
+				clearPathes();
 				findGreedyPathes();
 				return false;
 			}
@@ -767,31 +903,41 @@ bool SequenceGraph::findPathes() {
 	}
 	*/
 	//cout << "Found " << _pathes.size() << " pathes." << endl;
+	_pathHashes.clear();
 	return true;
 }
 
-unsigned int SequenceGraph::findMostSeenNode() const {
-	KmerNb       highestCount = 0;
-	unsigned int highestId    = -1;
+// The set nodes, by decreasing count.  Counts do not change while the
+// greedy pathes are extracted, and unset nodes are skipped when reached.
+void SequenceGraph::sortNodesByCount(vector <unsigned int> &nodeIds) const {
+	nodeIds.clear();
 	for (unsigned int nodeId = 0; nodeId < getSize(); nodeId++) {
-		if ((_nodes[nodeId].isSet()) && (_nodes[nodeId].getCount() > highestCount)) {
-			highestCount = _nodes[nodeId].getCount();
-			highestId    = nodeId;
+		if (_flags[nodeId] & NODE_SET) {
+			nodeIds.push_back(nodeId);
 		}
 	}
-	return highestId;
+	stable_sort(nodeIds.begin(), nodeIds.end(), [this](unsigned int n1, unsigned int n2) { return (_counts[n1] > _counts[n2]); });
+}
+
+unsigned int SequenceGraph::findMostSeenNode(const vector <unsigned int> &nodeIds, unsigned int &next) const {
+	for (; next < nodeIds.size(); next++) {
+		if ((_flags[nodeIds[next]] & NODE_SET) && (_counts[nodeIds[next]] > 0)) {
+			return nodeIds[next];
+		}
+	}
+	return -1;
 }
 
 pair < unsigned int, bool > SequenceGraph::findMostSeenNeighbor(const unsigned int nodeId, const unsigned short position) const {
-	const SequenceNode& node   = _nodes[nodeId];
+	const SequenceNode node    = getNode(nodeId);
 	KmerNb        highestCount = 0, count;
 	unsigned int  highestId    = -1, id;
 	short         highestDir   = 0;
 	for (short d = 0; d < Globals::DIRECTIONS; d++) {
 		for (int i = 0; i < node.getNbNeighbors(position, d); i++) {
 			id    = node.getNeighbor(position, d, i);
-			count = _nodes[id].getCount();
-			if ((_nodes[id].isSet()) && (count > highestCount)) {
+			count = _counts[id];
+			if ((_flags[id] & NODE_SET) && (count > highestCount)) {
 				highestCount = count;
 				highestId    = id;
 				highestDir   = d;
@@ -804,14 +950,20 @@ pair < unsigned int, bool > SequenceGraph::findMostSeenNeighbor(const unsigned i
 void SequenceGraph::findGreedyPathes() {
 	//cout << "Starting path finding with graph\n" << *this << endl;
 	static const unsigned int over = static_cast<unsigned int>(-1);
-	unsigned int highestId = findMostSeenNode(), currentId, nextId;
+	vector <unsigned int> nodeIds;
+	PathSpeller           speller;
+	unsigned int          next = 0;
+	freeze();
+	sortNodesByCount(nodeIds);
+	unsigned int highestId = findMostSeenNode(nodeIds, next), currentId, nextId;
 	short        highestDir, p, d;
 	while (highestId != over) {
-		SequenceNode &highestNode = _nodes[highestId];
-		string        sequence    = highestNode.getSequence().getWord(Globals::DIRECT);
+		SequenceNode  highestNode = getNode(highestId);
 		KmerNb        count       = highestNode.getCount();
 		unsigned int  cpt         = 1;
 		highestNode.unset();
+		speller.clear();
+		speller.append(highestNode.getSequence(), Globals::DIRECT);
 		for (short position = 0; position < Globals::POSITIONS; position++) {
 			currentId               = highestId;
 			p                       = position;
@@ -823,22 +975,22 @@ void SequenceGraph::findGreedyPathes() {
 					p = 1-p;
 					d = 1-d;
 				}
-				SequenceNode &currentNode     = _nodes[currentId];
-				string        currentSequence = currentNode.getSequence().getWord(d);
-				count                        += currentNode.getCount();
+				SequenceNode    currentNode      = getNode(currentId);
+				const Sequence &currentSequence  = currentNode.getSequence();
+				count                           += currentNode.getCount();
 				if (position == Globals::AFTER) {
-					sequence += currentSequence.substr(Globals::KMER-1);
+					speller.append(currentSequence, d, Globals::KMER-1);
 				}
 				else {
-					sequence = currentSequence.substr(0, currentSequence.size() - Globals::KMER + 1) + sequence;
+					speller.prepend(currentSequence, d, 0, currentSequence.getSize() - Globals::KMER + 1);
 				}
 				cpt++;
 				currentNode.unset();
 				tie(nextId, highestDir) = findMostSeenNeighbor(currentId, p);
 			}
 		}
-		highestId = findMostSeenNode();
-		_repeats.push_back(CountedRepeat(sequence, count / cpt));
+		highestId = findMostSeenNode(nodeIds, next);
+		_repeats.push_back(CountedRepeat(speller.getSequence(), count / cpt));
 	}
 	/*
 	cout << "Over with" << endl;
@@ -911,7 +1063,7 @@ bool SequenceGraph::isLeaf(const SequenceNode &n) const {
 		bool empty = true;
 		for (short direction = 0; (direction < Globals::DIRECTIONS) && (empty); direction++) {
 			for (int i = 0; (i < n.getNbNeighbors(position, direction)) && (empty); i++) {
-				if (_nodes[n.getNeighbor(position, direction, i)].isSet()) {
+				if ((_flags[n.getNeighbor(position, direction, i)] & NODE_SET)) {
 					empty = false;
 				}
 			}
@@ -927,7 +1079,7 @@ void SequenceGraph::countNeighbors(const SequenceNode &n, KmerNb *count) const {
 	for (short position = 0; position < Globals::POSITIONS; position++) {
 		for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
 			for (int i = 0; i < n.getNbNeighbors(position, direction); i++) {
-				if (_nodes[n.getNeighbor(position, direction, i)].isSet()) {
+				if ((_flags[n.getNeighbor(position, direction, i)] & NODE_SET)) {
 					count[position]++;
 				}
 			}
@@ -969,7 +1121,7 @@ bool SequenceGraph::isAlone(const SequenceNode &n) const {
 	for (short position = 0; position < Globals::POSITIONS; position++) {
 		for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
 			for (int i = 0; i < n.getNbNeighbors(position, direction); i++) {
-				if (_nodes[n.getNeighbor(position, direction, i)].isSet()) {
+				if ((_flags[n.getNeighbor(position, direction, i)] & NODE_SET)) {
 					return false;
 				}
 			}
@@ -984,7 +1136,7 @@ short SequenceGraph::getOnlyDirection(const SequenceNode &n) const {
 		//cout << " direction: " << direction;
 		for (int i = 0; i < n.getNbNeighbors(Globals::BEFORE, direction); i++) {
 			//cout << " i: " << i << _nodes[n.getNeighbor(Globals::BEFORE, direction, i)];
-			if (_nodes[n.getNeighbor(Globals::BEFORE, direction, i)].isSet()) {
+			if ((_flags[n.getNeighbor(Globals::BEFORE, direction, i)] & NODE_SET)) {
 				//cout << endl;
 				return Globals::BEFORE;
 			}
@@ -997,14 +1149,15 @@ short SequenceGraph::getOnlyDirection(const SequenceNode &n) const {
 unsigned int SequenceGraph::getCumulatedSize(const SequencePath &path) const {
 	unsigned int sum = Globals::KMER-1;
 	for (unsigned int i = 0; i < path.getSize(); i++) {
-		sum += _nodes[path.getNode(i)].getSize() - (Globals::KMER-1);
+		sum += _sequences[path.getNode(i)].getSize() - (Globals::KMER-1);
 	}
 	return sum;
 }
 
 void SequenceGraph::findLeaves() {
 	_leaves.clear();
-	for (SequenceNode &node: _nodes) {
+	for (unsigned int i = 0; i < getSize(); i++) {
+		SequenceNode node = getNode(i);
 		if ((node.isSet()) && (isLeaf(node))) {
 			_leaves.push_back(node.getId());
 		}
@@ -1012,7 +1165,8 @@ void SequenceGraph::findLeaves() {
 }
 
 void SequenceGraph::removeMarkedNodes() {
-	for (SequenceNode &node: _nodes) {
+	for (unsigned int i = 0; i < getSize(); i++) {
+		SequenceNode node = getNode(i);
 		if (node.isMarked()) {
 			node.unset();
 		}
@@ -1318,20 +1472,32 @@ void SequenceGraph::findCycles(SequencePath &path, short position) {
 }
 */
 
+// The hashes of the pathes are only indexed while finding the pathes.
 bool SequenceGraph::checkPath(const SequencePath &path) const {
-	for (const SequencePath &storedPath: _pathes) {
-		if (path == storedPath) {
+	auto range = _pathHashes.equal_range(path.getHash());
+	for (auto it = range.first; it != range.second; ++it) {
+		if (path == _pathes[it->second]) {
 			return false;
 		}
 	}
 	return true;
 }
 
+void SequenceGraph::addPath(const SequencePath &path) {
+	_pathHashes.insert(make_pair(path.getHash(), _pathes.size()));
+	_pathes.push_back(path);
+}
+
+void SequenceGraph::clearPathes() {
+	_pathes.clear();
+	_pathHashes.clear();
+}
+
 void SequenceGraph::selectPathes(const KmerNb threshold) {
 	if (_pathes.empty()) {
 		return;
 	}
-	set <unsigned int> nodeIds;
+	vector <bool> nodeIds(getSize(), false);
 	vector <SequencePath> selectedPathes;
 	for (SequencePath &path: _pathes) {
 		if (path.getCount() < threshold) {
@@ -1343,13 +1509,13 @@ void SequenceGraph::selectPathes(const KmerNb threshold) {
 		if (! path.empty()) {
 			bool found = false;
 			for (unsigned int n = 0; (n < path.getSize()) && (! found); n++) {
-				if (nodeIds.find(path.getNode(n)) != nodeIds.end()) {
+				if (nodeIds[path.getNode(n)]) {
 					found = true;
 				}
 			}
 			if (! found) {
 				for (unsigned int n = 0; n < path.getSize(); n++) {
-					nodeIds.insert(path.getNode(n));
+					nodeIds[path.getNode(n)] = true;
 				}
 				selectedPathes.push_back(path);
 			}
@@ -1373,18 +1539,18 @@ vector <SequencePath> &SequenceGraph::getPathes() {
 
 vector <CountedRepeat> &SequenceGraph::getRepeats() {
 	if (_repeats.empty()) {
+		PathSpeller speller;
 		for (const SequencePath &path: _pathes) {
 			int                  id1       = path.getNode(0);
-			const  SequenceNode &n1        = _nodes[id1];
-			const  Sequence     &seq1      = n1.getSequence();
-			string               str1      = (n1.isDirect())? seq1.getWord(Globals::DIRECT): seq1.getWord(Globals::REVERSE);
+			const  SequenceNode  n1        = getNode(id1);
 			short                position  = Globals::POSITIONS;
 			short                direction = Globals::DIRECT;
 			//cout << "Making sequence from path " << path << endl;
-			//cout << "\tStarting with node " << n1 << " and string " << str1 << endl;
+			speller.clear();
+			speller.append(n1.getSequence(), (n1.isDirect())? Globals::DIRECT: Globals::REVERSE);
 			for (unsigned int j = 1; j < path.getSize(); j++) {
 				int                  id2       = path.getNode(j);
-				const  SequenceNode &n2        = _nodes[id2];
+				const  SequenceNode  n2        = getNode(id2);
 				short                p         = path.getNodePosition(j);
 				short                d         = path.getNodeDirection(j);
 				const  Sequence     &seq2      = n2.getSequence();
@@ -1394,26 +1560,31 @@ vector <CountedRepeat> &SequenceGraph::getRepeats() {
 				if (d == Globals::REVERSE) {
 					direction = 1-direction;
 				}
-				string str2 = seq2.getWord((n2.isDirect())? direction: 1-direction);
-				//cout << "\tAdding node " << n2 << " and string " << str2 << endl;
+				short direction2 = (n2.isDirect())? direction: 1-direction;
+				//cout << "\tAdding node " << n2 << endl;
 				if (position == Globals::AFTER) {
-					str1 += str2.substr(Globals::KMER-1);
+					speller.append(seq2, direction2, Globals::KMER-1);
 				}
 				else {
-					str1 = str2.substr(0, str2.size() - Globals::KMER + 1) + str1;
+					speller.prepend(seq2, direction2, 0, seq2.getSize() - Globals::KMER + 1);
 				}
-				//cout << "\t\tSumming to " << str1 << endl;
 			}
-			_repeats.push_back(CountedRepeat(str1, path.getCount(), path.isCycle()));
+			_repeats.push_back(CountedRepeat(speller.getSequence(), path.getCount(), path.isCycle()));
 		}
 	}
 	return _repeats;
 }
 
 void SequenceGraph::clear() {
-	_nodes.clear();
+	_counts.clear();
+	_sequences.clear();
+	_flags.clear();
+	_offsets.clear();
+	_links.clear();
+	_overlay.clear();
+	_newLinks.clear();
 	_leaves.clear();
-	_pathes.clear();
+	clearPathes();
 }
 
 bool SequenceGraph::check () const {
@@ -1424,7 +1595,8 @@ bool SequenceGraph::check () const {
 	bool returnValue = false;
 	for (unsigned int sequencePos = 0; sequencePos < Globals::CHECK.size() - Globals::KMER + 1; sequencePos++) {
 		string part  = Globals::CHECK.substr(sequencePos, Globals::KMER);
-		for (const SequenceNode &node: _nodes) {
+		for (unsigned int i = 0; i < getSize(); i++) {
+			const SequenceNode node = getNode(i);
 			for (short direction = 0; direction < Globals::DIRECTIONS; direction++) {
 				string sequence = node.getSequence().getWord(direction);
 				size_t index    = sequence.find(part);
@@ -1440,7 +1612,8 @@ bool SequenceGraph::check () const {
 
 ostream& operator<<(ostream& output, const SequenceGraph& g) {
 	output << "Nodes:\n";
-	for (const SequenceNode &node: g._nodes) {
+	for (unsigned int i = 0; i < g.getSize(); i++) {
+		const SequenceNode node = g.getNode(i);
 		if (node.isSet()) {
 			output << node << "\n";
 		}
@@ -1448,7 +1621,7 @@ ostream& operator<<(ostream& output, const SequenceGraph& g) {
 	if (! g._leaves.empty()) {
 		output << "Leaves:\n";
 		for (unsigned int leafId: g._leaves) {
-			const SequenceNode &node = g._nodes[leafId];
+			const SequenceNode node = g.getNode(leafId);
 			if (node.isSet()) {
 				output << node << "\n";
 			}
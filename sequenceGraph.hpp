@@ -18,35 +18,34 @@ along with this program.
 
 #include <iostream>
 #include <vector>
+#include <array>
 #include <set>
+#include <unordered_map>
 #include <algorithm>
 #include <mutex>
 #include "globals.hpp"
 #include "sequence.hpp"
 #include "repeats.hpp"
+#include "arena.hpp"
 using namespace std;
 
 
+class SequenceGraph;
+
+// Handle on a node of a graph: the attributes and the links of the nodes are
+// stored in the graph.
 class SequenceNode {
 
 	private:
-		unsigned int _id;
-		KmerNb       _count;
-		Sequence     _sequence;
-		bool         _set;
-		bool         _marked;
-		bool         _direct;
-		vector <unsigned int> _neighbors[Globals::POSITIONS][Globals::DIRECTIONS];
+		SequenceGraph *_graph;
+		unsigned int   _id;
 
 	public:
-		SequenceNode (unsigned int id = -1, KmerNb count = 0);
-		SequenceNode (unsigned int id, KmerNb count, const Sequence &sequence);
-
-		void addNeighbor(unsigned int id, short position, short direction);
+		SequenceNode (SequenceGraph *graph, unsigned int id);
 
-		void setId(unsigned int id);
 		unsigned int getId() const;
 		unsigned int getSize() const;
+		unsigned int getNbKmers() const;
 		const Sequence &getSequence() const;
 		void setSequence(const Sequence sequence);
 		KmerNb getCount() const;
@@ -72,11 +71,15 @@ class SequenceNode {
 class SequencePath {
 
 	private:
-		vector < tuple <short, short, unsigned int> > _nodes;
-		set    < unsigned int > _nodeIds;
+		ArenaVector < tuple <short, short, unsigned int> > _nodes;
+		ArenaVector < unsigned int > _nodeIds;
+		size_t _hash;
 		bool   _cycle;
 		KmerNb _count;
 
+		void insertNodeId(unsigned int id);
+		void eraseNodeId(unsigned int id);
+
 	public:
 		SequencePath ();
 		SequencePath (const SequencePath &path);
@@ -103,6 +106,8 @@ class SequencePath {
 		void setCount(const KmerNb count);
 		KmerNb getCount() const;
 
+		size_t getHash() const;
+
 		bool contains(int id) const;
 		bool contains(const SequencePath &p) const;
 		bool crosses(const SequencePath &p) const;
@@ -121,13 +126,35 @@ class SequencePath {
 };
 
 
+// The attributes of the nodes are stored column-wise.
+// The links are stored in a compressed sparse row layout: the neighbors of
+// each side (position and direction) of each node are contiguous.  The
+// links added while building the graph are kept aside, and the lists which
+// are changed afterwards are copied in an overlay, until the next call to
+// freeze(), which rebuilds the layout.
 class SequenceGraph {
 
+	friend class SequenceNode;
+
 	private:
+		static constexpr unsigned int  NB_SIDES    = Globals::POSITIONS * Globals::DIRECTIONS;
+		static constexpr unsigned char NODE_SET    = 1;
+		static constexpr unsigned char NODE_MARKED = 2;
+		static constexpr unsigned char NODE_DIRECT = 4;
+
+		typedef array <ArenaVector <unsigned int>, NB_SIDES> Links;
+
 		unsigned int _maxPaths;
-		vector <SequenceNode> _nodes;
-		vector <unsigned int>  _leaves;
+		ArenaVector <KmerNb>        _counts;
+		ArenaVector <Sequence>      _sequences;
+		ArenaVector <unsigned char> _flags;
+		ArenaVector <unsigned int>  _offsets;
+		ArenaVector <unsigned int>  _links;
+		unordered_map <unsigned int, Links, hash <unsigned int>, equal_to <unsigned int>, ArenaAllocator <pair <const unsigned int, Links> > > _overlay;
+		ArenaVector <pair <unsigned int, unsigned int> > _newLinks;
+		ArenaVector <unsigned int>  _leaves;
 		vector <SequencePath>  _pathes;
+		unordered_multimap <size_t, unsigned int> _pathHashes;
 		vector <CountedRepeat> _repeats;
 
 	public:
@@ -143,7 +170,11 @@ class SequenceGraph {
 		void addNode(unsigned int id, KmerNb count);
 		void addNode(unsigned int id, KmerNb count, const Sequence &sequence);
 		void addLink(unsigned int n1, short pos1, short dir1, unsigned int n2);
-		SequenceNode &getNode(const unsigned int i);
+		SequenceNode getNode(const unsigned int i);
+		const SequenceNode getNode(const unsigned int i) const;
+		unsigned int getNbNeighbors(const unsigned int i, const short position, const short direction) const;
+		unsigned int getNeighbor(const unsigned int i, const short position, const short direction, const unsigned int n) const;
+		void freeze();
 		unsigned int getCumulatedSize(const SequencePath &path) const;
 		bool findAllPathes();
 		void findGreedyPathes();
@@ -169,12 +200,17 @@ class SequenceGraph {
 		//void findPathes(unsigned int leafId, mutex &m1);
 		//void findPathes(SequencePath &path, short position, mutex &m1);
 		bool checkPath(const SequencePath &p) const;
+		void addPath(const SequencePath &p);
+		void clearPathes();
 		bool comparePathes(const SequencePath &p1, const SequencePath &p2) const;
 		void countNeighbors(const SequenceNode &node, KmerNb *count) const;
 		short getOnlyDirection(const SequenceNode &n) const;
 		void removeMarkedNodes();
+		Links &getLinks(const unsigned int i);
+		void copyLinks(const unsigned int i, const short side, ArenaVector <unsigned int> &links) const;
 
-		unsigned int findMostSeenNode() const;
+		void sortNodesByCount(vector <unsigned int> &nodeIds) const;
+		unsigned int findMostSeenNode(const vector <unsigned int> &nodeIds, unsigned int &next) const;
 		pair < unsigned int, bool > findMostSeenNeighbor(const unsigned int nodeId, const unsigned short position) const;
 
 		struct PathComparator { 
@@ -18,9 +18,13 @@ along with this program.
 #endif
 
 #include <limits>
+#include <thread>
 #include "globals.hpp"
 #include "simpleKmerCount.hpp"
 
+constexpr unsigned int SimpleKmerCount::EDGE_SHIFT;
+constexpr KmerNb       SimpleKmerCount::COUNT_MASK;
+
 SimpleKmerCount::SimpleKmerCount(): _maxCount(0), _minCount(0), _nbValues(0) { }
 
 void SimpleKmerCount::addKmer(const Kmer &kmer, bool insert) {
@@ -34,11 +38,42 @@ void SimpleKmerCount::addKmer(const Kmer &kmer, mutex &m) {
 }
 
 KmerNb SimpleKmerCount::getCount(const Kmer &kmer) const {
-	auto it = _map.find(kmer.getFirstCode());
+	return getCount(kmer.getFirstCode());
+}
+
+KmerNb SimpleKmerCount::getCount(const KmerCode &code) const {
+	if (! _filter.contains(code)) {
+		return 0;
+	}
+	auto it = _map.find(code);
+	if (it == _map.end()) {
+		return 0;
+	}
+	return it->second & COUNT_MASK;
+}
+
+void SimpleKmerCount::getCounts(const KmerCode *codes, const unsigned int n, KmerNb *counts, unsigned char *edges) const {
+	for (unsigned int i = 0; i < n; i++) {
+		KmerNb value = 0;
+		if (_filter.contains(codes[i])) {
+			auto it = _map.find(codes[i]);
+			if (it != _map.end()) {
+				value = it->second;
+			}
+		}
+		counts[i] = value & COUNT_MASK;
+		if (edges != nullptr) {
+			edges[i] = value >> EDGE_SHIFT;
+		}
+	}
+}
+
+unsigned char SimpleKmerCount::getEdges(const KmerCode &code) const {
+	auto it = _map.find(code);
 	if (it == _map.end()) {
 		return 0;
 	}
-	return it->second;
+	return it->second >> EDGE_SHIFT;
 }
 
 bool SimpleKmerCount::isPresent(const KmerCode &kmerCode) const {
@@ -53,7 +88,7 @@ void SimpleKmerCount::decreaseNb(const KmerCode &kmerCode, const KmerNb nb) {
 	if (! isPresent(kmerCode)) {
 		return;
 	}
-	KmerNb count = _map[kmerCode];
+	KmerNb count = _map[kmerCode] & COUNT_MASK;
 	if (count <= nb + _minCount) {
 		_nbValues -= count;
 		_map.erase(kmerCode);
@@ -69,26 +104,24 @@ void SimpleKmerCount::decreaseNb(const Kmer &kmer, const KmerNb nb) {
 }
 
 void SimpleKmerCount::remove(const KmerCode &kmerCode) {
-	_nbValues -= _map[kmerCode];
+	_nbValues -= _map[kmerCode] & COUNT_MASK;
 	_map.erase(kmerCode);
 }
 
 void SimpleKmerCount::remove(const Kmer &kmer) {
-	KmerCode code = kmer.getFirstCode();
-	_nbValues -= _map[code];
-	_map.erase(code);
+	remove(kmer.getFirstCode());
 }
 
 void SimpleKmerCount::computeCountDistribution() {
 	_maxCount = 0;
 	_nbValues = 0;
 	for (auto it = _map.begin(); it != _map.end(); ++it) {
-		_maxCount = max<KmerNb>(_maxCount, it->second);
-		_nbValues += it->second;
+		_maxCount = max<KmerNb>(_maxCount, it->second & COUNT_MASK);
+		_nbValues += it->second & COUNT_MASK;
 	}
 	_countDistribution.assign(_maxCount+1, 0);
 	for (auto it = _map.begin(); it != _map.end(); ++it) {
-		++_countDistribution[it->second];
+		++_countDistribution[it->second & COUNT_MASK];
 	}
 }
 
@@ -134,8 +167,9 @@ KmerNb SimpleKmerCount::getThreshold(int percent) const {
 
 void SimpleKmerCount::removeUnder(KmerNb nb) {
 	for (auto it = _map.begin(); it != _map.end(); ) {
-		if (it->second < nb) {
-			_nbValues -= it->second;
+		KmerNb count = it->second & COUNT_MASK;
+		if (count < nb) {
+			_nbValues -= count;
 			_map.erase(it++);
 		}
 		else {
@@ -148,9 +182,9 @@ KmerCode SimpleKmerCount::getMostFrequent() {
 	KmerCode index = 0;
 	KmerNb   value = 0;
 	for (auto it = _map.begin(); it != _map.end(); ++it) {
-		if (it->second > value) {
+		if ((it->second & COUNT_MASK) > value) {
 			index = it->first;
-			value = it->second;
+			value = it->second & COUNT_MASK;
 		}
 	}
 	return index;
@@ -160,9 +194,9 @@ KmerCode SimpleKmerCount::getLeastFrequent() {
 	KmerCode index = 0;
 	KmerNb   value = -1;
 	for (auto it = _map.begin(); it != _map.end(); ++it) {
-		if (it->second < value) {
+		if ((it->second & COUNT_MASK) < value) {
 			index = it->first;
-			value = it->second;
+			value = it->second & COUNT_MASK;
 		}
 	}
 	return index;
@@ -173,7 +207,55 @@ pair <KmerCode, KmerNb> SimpleKmerCount::getRandom() {
 	if (it == _map.end()) {
 		return make_pair(Kmer::UNSET, 0);
 	}
-	return *it;
+	return make_pair(it->first, it->second & COUNT_MASK);
+}
+
+void SimpleKmerCount::getKmers(vector <KmerCode> &codes, vector <KmerNb> &counts) const {
+	codes.clear();
+	counts.clear();
+	codes.reserve(_map.size());
+	counts.reserve(_map.size());
+	for (auto it = _map.begin(); it != _map.end(); ++it) {
+		codes.push_back(it->first);
+		counts.push_back(it->second & COUNT_MASK);
+	}
+}
+
+void SimpleKmerCount::buildFilter() {
+	_filter.resize(_map.size());
+	for (auto it = _map.begin(); it != _map.end(); ++it) {
+		_filter.add(it->first);
+	}
+}
+
+void SimpleKmerCount::buildEdges() {
+	vector <KmerCode>      codes;
+	vector <KmerNb>        counts;
+	vector <unsigned char> edges;
+	vector <thread>        threads;
+	unsigned int           nbThreads = max<int>(Globals::NB_THREADS, 1);
+	getKmers(codes, counts);
+	edges.resize(codes.size());
+	for (unsigned int threadId = 0; threadId < nbThreads; threadId++) {
+		threads.emplace_back([&, threadId]() {
+			for (unsigned int i = threadId; i < codes.size(); i += nbThreads) {
+				Kmer kmer(codes[i]);
+				for (short position = 0; position < Globals::POSITIONS; position++) {
+					for (short nucleotide = 0; nucleotide < Globals::NB_NUCLEOTIDES; nucleotide++) {
+						if (isPresent(kmer.getCodeNeighbor(nucleotide, position))) {
+							edges[i] |= 1 << (position * Globals::NB_NUCLEOTIDES + nucleotide);
+						}
+					}
+				}
+			}
+		});
+	}
+	for (thread &t: threads) {
+		t.join();
+	}
+	for (unsigned int i = 0; i < codes.size(); i++) {
+		_map.find(codes[i])->second |= static_cast<KmerNb>(edges[i]) << EDGE_SHIFT;
+	}
 }
 
 bool SimpleKmerCount::empty() const {
@@ -182,6 +264,7 @@ bool SimpleKmerCount::empty() const {
 
 void SimpleKmerCount::clear() {
 	_map.clear();
+	_filter.clear();
 	_countDistribution.clear();
 }
 
@@ -191,7 +274,7 @@ unsigned int SimpleKmerCount::getSize() const {
 
 ostream& operator<<(ostream& output, SimpleKmerCount& kc) {
 	for (auto it = kc._map.begin(); it != kc._map.end(); ++it) {
-		output << Kmer(it->first) << "\t" << it->second << endl;
+		output << Kmer(it->first) << "\t" << (it->second & SimpleKmerCount::COUNT_MASK) << endl;
 	}
 	return output;
 }
@@ -22,11 +22,16 @@ along with this program.
 #include "globals.hpp"
 #include "hashes.hpp"
 #include "kmer.hpp"
+#include "kmerCount.hpp"
 using namespace std;
 
-class SimpleKmerCount {
+// Once the edges are computed, the edge mask of a k-mer is stored in the upper bits of its count.
+class SimpleKmerCount: public KmerCount {
 
     protected:
+		static constexpr unsigned int EDGE_SHIFT = 56;
+		static constexpr KmerNb       COUNT_MASK = (static_cast<KmerNb>(1) << EDGE_SHIFT) - 1;
+
 #ifdef HASH_MID
 		SimpleHash        _map;
 #endif
@@ -46,6 +51,9 @@ class SimpleKmerCount {
 		void addKmer (const Kmer &kmer, bool insert=true);
 		void addKmer (const Kmer &kmer, mutex &m);
 		KmerNb getCount (const Kmer &kmer) const;
+		KmerNb getCount (const KmerCode &code) const;
+		void getCounts (const KmerCode *codes, const unsigned int n, KmerNb *counts, unsigned char *edges = nullptr) const;
+		unsigned char getEdges (const KmerCode &code) const;
 		bool isPresent (const KmerCode &kmerCode) const;
 		bool isPresent (const Kmer &kmer) const;
 		void decreaseNb (const KmerCode &kmerCode, const KmerNb nb);
@@ -62,6 +70,9 @@ class SimpleKmerCount {
 		KmerCode getLeastFrequent();
 		KmerCode getMostFrequent();
 		pair <KmerCode, KmerNb> getRandom();
+		void getKmers(vector <KmerCode> &codes, vector <KmerNb> &counts) const;
+		void buildFilter();
+		void buildEdges();
 		bool empty() const;
 		void clear();
 		unsigned int getSize() const;
@@ -22,7 +22,7 @@ along with this program.
 #include "optionparser.h"
 #include "assembler.hpp"
 
-enum  optionIndex {UNKNOWN, INPUT1, INPUT2, INSERT, KMER, OUTPUT, THRESHOLD, PROCESSORS, REPEAT_FREQUENCY, MIN_FREQUENCY, FREQUENCY_DIF, SMALL_GRAPH, BIG_GRAPH, NB_SMALL_GRAPH, MAX_PATHS, EROSION, BUBBLE_SIZE, MIN_LTR, MAX_LTR, MAX_IDENTITY, MIN_OVERLAP, MAX_OVERLAP, SHORT_KMER, INDEL_PEN, MISMATCH_PEN, SIZE_PEN, MAX_PEN, MIN_IDENTITY, MERGE_MAX_NB, MERGE_MAX_NODES, MIN_SCAFFOLD, MAX_SCAFFOLD, SCAFFOLD_MAX_EV, MAX_EVIDENCES, MIN_TE_SIZE, MAX_TE_SIZE, FASTA_INPUT, BYTES_PER_THREAD, MAX_KMERS, MAX_READS, CHECK, HELP, VERSION};
+enum  optionIndex {UNKNOWN, INPUT1, INPUT2, INSERT, KMER, OUTPUT, THRESHOLD, PROCESSORS, REPEAT_FREQUENCY, MIN_FREQUENCY, FREQUENCY_DIF, SMALL_GRAPH, BIG_GRAPH, NB_SMALL_GRAPH, MAX_PATHS, EROSION, BUBBLE_SIZE, FROZEN_INDEX, UNITIGS, MIN_LTR, MAX_LTR, MAX_IDENTITY, MIN_SHARED_SEEDS, CONTAINMENT_FILTER, MIN_OVERLAP, MAX_OVERLAP, SHORT_KMER, SKETCH_SCALE, OVERLAP_INDEX, INDEL_PEN, MISMATCH_PEN, SIZE_PEN, MAX_PEN, MIN_IDENTITY, MERGE_MAX_NB, MERGE_MAX_NODES, MIN_SCAFFOLD, MAX_SCAFFOLD, SCAFFOLD_MAX_EV, MAX_EVIDENCES, MIN_TE_SIZE, MAX_TE_SIZE, FASTA_INPUT, BYTES_PER_THREAD, MAX_KMERS, MAX_READS, CHECK, HELP, VERSION};
 const option::Descriptor usage[] = {
 	{UNKNOWN,          0, "" , ""                  , option::Arg::None    , "USAGE: tedna [options]\n\n" "Compulsory options:"},
 	{INPUT1,           0, "1", "file1"             , option::Arg::Required, "  -1, --file1  \tFirst FASTQ file."},
@@ -49,15 +49,21 @@ const option::Descriptor usage[] = {
 	{MAX_PATHS,        0, "" , "max-paths"         , option::Arg::Numeric,  "  --max-paths          \tMaximum # paths                    (default: 100), 0: never stop."},
 	{EROSION,          0, "" , "erosion"           , option::Arg::Numeric,  "  --erosion            \tErosion strength                   (default: 100)."},
 	{BUBBLE_SIZE,      0, "" , "bubble-size"       , option::Arg::Numeric,  "  --bubble-size        \tSize of the bubbles                (default: 1000)."},
+	{FROZEN_INDEX,     0, "" , "frozen-index"      , option::Arg::None    , "  --frozen-index       \tUse a static k-mer index for graphs (default: not set)."},
+	{UNITIGS,          0, "" , "unitigs"           , option::Arg::None    , "  --unitigs            \tBuild graphs of unitigs, implies --frozen-index (default: not set)."},
 	{UNKNOWN,          0, "" ,  ""                 , option::Arg::None    , "\n  LTR elements:"},                                      
 	{MIN_LTR,          0, "" , "min-ltr"           , option::Arg::Numeric,  "  --min-ltr            \tMinimum LTR size                   (default: 50)."},
 	{MAX_LTR,          0, "" , "max-ltr"           , option::Arg::Numeric,  "  --max-ltr            \tMaximum LTR size                   (default: 5000)."},
 	{UNKNOWN,          0, "" ,  ""                 , option::Arg::None    , "\n  duplicate removal:"},                                       
 	{MAX_IDENTITY,     0, "" , "duplicate-id"      , option::Arg::Numeric,  "  --duplicate-id       \tMaximum id. to remove duplicate    (default: 30%)."},
+	{MIN_SHARED_SEEDS, 0, "" , "min-shared-seeds"  , option::Arg::Numeric,  "  --min-shared-seeds   \tMin. short k-mers shared by dup.   (default: 1)."},
+	{CONTAINMENT_FILTER, 0, "" , "containment-filter", option::Arg::None  , "  --containment-filter \tReject dup. by seed containment    (default: not set)."},
 	{UNKNOWN,          0, "" ,  ""                 , option::Arg::None    , "\n  merge:"},                                             
 	{MIN_OVERLAP,      0, "" , "min-overlap"       , option::Arg::Numeric,  "  --min-overlap        \tMinimum overlap to merge TEs       (default: 20)."},
 	{MAX_OVERLAP,      0, "" , "max-overlap"       , option::Arg::Numeric,  "  --max-overlap        \tMaximum overlap to merge TEs       (default: 500)."},
 	{SHORT_KMER,       0, "" , "short-kmer"        , option::Arg::Numeric,  "  --short-kmer         \tSmall k-mer size                   (default: 15)."},
+	{SKETCH_SCALE,     0, "" , "sketch-scale"      , option::Arg::Numeric,  "  --sketch-scale       \tSketch scale (1: all k-mers)       (default: 1)."},
+	{OVERLAP_INDEX,    0, "" , "overlap-index"     , option::Arg::None    , "  --overlap-index      \tOnly align the ends sharing a seed (default: not set)."},
 	{INDEL_PEN,        0, "" , "indel-pen"         , option::Arg::Numeric,  "  --indel-pen          \tIndel penalty                      (default: 30)."},
 	{MISMATCH_PEN,     0, "" , "mismatch-pen"      , option::Arg::Numeric,  "  --mismatch-pen       \tMismatch penalty                   (default: 10)."},
 	{SIZE_PEN,         0, "" , "size-pen"          , option::Arg::Numeric,  "  --size-pen           \tSize penalty                       (default: 1)."},
@@ -191,18 +197,32 @@ int main(int argc, char **argv) {
 		Globals::EROSION_STRENGTH = atoi(options[EROSION].arg);
 	if (options[BUBBLE_SIZE])
 		Globals::BUBBLE_SIZE = atoi(options[BUBBLE_SIZE].arg);
+	if (options[FROZEN_INDEX])
+		Globals::FROZEN_INDEX = true;
+	if (options[UNITIGS]) {
+		Globals::FROZEN_INDEX = true;
+		Globals::UNITIGS      = true;
+	}
 	if (options[MIN_LTR])
 		Globals::MIN_LTR_SIZE = atoi(options[MIN_LTR].arg);
 	if (options[MAX_LTR])
 		Globals::MAX_LTR_SIZE = atoi(options[MAX_LTR].arg);
 	if (options[MAX_IDENTITY])
 		Globals::MAX_IDENTITY = atoi(options[MAX_IDENTITY].arg) / 100.0;
+	if (options[MIN_SHARED_SEEDS])
+		Globals::MIN_SHARED_SEEDS = strtoul(options[MIN_SHARED_SEEDS].arg, NULL, 0);
+	if (options[CONTAINMENT_FILTER])
+		Globals::CONTAINMENT_FILTER = true;
 	if (options[MIN_OVERLAP])
 		Globals::MIN_MERGE_SIZE = atoi(options[MIN_OVERLAP].arg);
 	if (options[MAX_OVERLAP])
 		Globals::MAX_MERGE_SIZE = atoi(options[MAX_OVERLAP].arg);
 	if (options[SHORT_KMER])
 		Globals::SHORT_KMER_SIZE = strtoul(options[SHORT_KMER].arg, NULL, 0);
+	if (options[SKETCH_SCALE])
+		Globals::SKETCH_SCALE = strtoul(options[SKETCH_SCALE].arg, NULL, 0);
+	if (options[OVERLAP_INDEX])
+		Globals::OVERLAP_INDEX = true;
 	if (options[INDEL_PEN])
 		Globals::PENALTY_INDEL = atoi(options[INDEL_PEN].arg);
 	if (options[MISMATCH_PEN])